@@ -0,0 +1,336 @@
+/** @file
+   Strojenie progów wyboru algorytmu mnożenia wielomianów
+
+   Program mierzy na bieżącej maszynie czasy mnożenia gęstych wielomianów
+   różnymi metodami, wyznacza długości, przy których opłaca się zmiana
+   metody, i zapisuje progi funkcją PolyMulSaveTuning do pliku podanego
+   jako argument. Kalkulator wczytuje ten plik przy starcie.
+
+   @author Piotr Szuberski <p.szuberski@student.uw.edu.pl>,
+   @copyright Uniwersytet Warszawski
+   @date 2026-10-18,
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include "mem_pool.h"
+#include "region.h"
+#include "poly.h"
+
+/** Najkrótszy czas pomiaru jednego wariantu w sekundach */
+#define TUNE_MIN_TIME 0.05
+
+/** Długość czynników przy strojeniu progu Karatsuby */
+#define TUNE_KARATSUBA_LENGTH 1024
+
+/** Najkrótsza badana długość czynników przy strojeniu progu NTT */
+#define TUNE_NTT_MIN 256
+
+/** Najdłuższa badana długość czynników przy strojeniu progu NTT */
+#define TUNE_NTT_MAX 65536
+
+/** Największy bok kwadratu wykładników przy strojeniu podstawienia
+ * Kroneckera */
+#define TUNE_KRONECKER_MAX 24
+
+/** Najmniejsza badana liczba punktów przy strojeniu wartościowania
+ * w wielu punktach */
+#define TUNE_MULTIPOINT_MIN 4096
+
+/** Największa badana liczba punktów przy strojeniu wartościowania
+ * w wielu punktach */
+#define TUNE_MULTIPOINT_MAX 131072
+
+/** Największy moduł małych współczynników */
+#define TUNE_SMALL_COEFF 16
+
+/** Badane długości, poniżej których Karatsuba przechodzi na mnożenie
+ * szkolne */
+static const size_t karatsuba_cutoffs[] = {8, 16, 24, 32, 48, 64, 128, 256};
+
+/**
+ * Losuje niezerowy współczynnik.
+ * @param[in] small : czy współczynnik ma być mały?
+ * @return współczynnik
+ */
+static poly_coeff_t RandomCoeff(bool small)
+{
+    poly_coeff_t c;
+
+    if (small) {
+        c = rand() % (2 * TUNE_SMALL_COEFF + 1) - TUNE_SMALL_COEFF;
+        return c != 0 ? c : 1;
+    }
+    c = (poly_coeff_t) (((uint64_t) rand() << 42) ^
+                        ((uint64_t) rand() << 21) ^ (uint64_t) rand());
+    return c != 0 ? c : 1;
+}
+
+/**
+ * Tworzy gęsty wielomian zmiennej x_0 o losowych współczynnikach.
+ * @param[in] n : liczba jednomianów
+ * @param[in] small : czy współczynniki mają być małe?
+ * @return wielomian stopnia `n - 1`
+ */
+static Poly DenseUnivariate(size_t n, bool small)
+{
+    Mono *monos = (Mono*) malloc(sizeof(Mono) * n);
+    Poly coeff, p;
+
+    for (size_t i = 0; i < n; i++) {
+        coeff = PolyFromCoeff(RandomCoeff(small));
+        monos[i] = MonoFromPoly(&coeff, (poly_exp_t) i);
+    }
+    p = PolyAddMonos((unsigned) n, monos);
+    free(monos);
+    return p;
+}
+
+/**
+ * Tworzy gęsty wielomian zmiennych x_0, x_1 o wykładnikach z kwadratu
+ * o boku @p k i małych losowych współczynnikach.
+ * @param[in] k : bok kwadratu wykładników
+ * @return wielomian o `k * k` jednomianach
+ */
+static Poly DenseBivariate(size_t k)
+{
+    Mono *monos = (Mono*) malloc(sizeof(Mono) * k);
+    Poly coeff, p;
+
+    for (size_t i = 0; i < k; i++) {
+        coeff = DenseUnivariate(k, true);
+        monos[i] = MonoFromPoly(&coeff, (poly_exp_t) i);
+    }
+    p = PolyAddMonos((unsigned) k, monos);
+    free(monos);
+    return p;
+}
+
+/**
+ * Mierzy średni czas mnożenia dwóch wielomianów przy danych progach.
+ * @param[in] p : wielomian
+ * @param[in] q : wielomian
+ * @param[in] tuning : progi wyboru algorytmu mnożenia
+ * @return czas jednego mnożenia w sekundach
+ */
+static double TimeMul(const Poly *p, const Poly *q,
+                      const PolyMulTuning *tuning)
+{
+    clock_t start, elapsed;
+    unsigned reps = 0;
+    Poly product;
+
+    PolyMulSetTuning(tuning);
+    start = clock();
+    do {
+        product = PolyMul(p, q);
+        PolyDestroy(&product);
+        reps++;
+        elapsed = clock() - start;
+    } while (elapsed < (clock_t) (TUNE_MIN_TIME * CLOCKS_PER_SEC));
+    return (double) elapsed / CLOCKS_PER_SEC / reps;
+}
+
+/**
+ * Mierzy średni czas wartościowania wielomianu w @p k punktach przy
+ * danych progach.
+ * @param[in] p : wielomian jednej zmiennej
+ * @param[in] k : liczba punktów
+ * @param[in] xs : punkty
+ * @param[out] out : wartości w punktach
+ * @param[in] tuning : progi wyboru algorytmu
+ * @return czas jednego wartościowania w sekundach
+ */
+static double TimeAtMany(const Poly *p, size_t k, const poly_coeff_t xs[],
+                         poly_coeff_t out[], const PolyMulTuning *tuning)
+{
+    clock_t start, elapsed;
+    unsigned reps = 0;
+
+    PolyMulSetTuning(tuning);
+    start = clock();
+    do {
+        PolyAtMany(p, k, xs, out);
+        reps++;
+        elapsed = clock() - start;
+    } while (elapsed < (clock_t) (TUNE_MIN_TIME * CLOCKS_PER_SEC));
+    return (double) elapsed / CLOCKS_PER_SEC / reps;
+}
+
+/**
+ * Wybiera długość, poniżej której Karatsuba przechodzi na mnożenie szkolne.
+ * @param[in] tuning : progi, do których wpisywany jest wynik
+ */
+static void TuneKaratsuba(PolyMulTuning *tuning)
+{
+    PolyMulTuning trial = *tuning;
+    Poly p = DenseUnivariate(TUNE_KARATSUBA_LENGTH, false);
+    Poly q = DenseUnivariate(TUNE_KARATSUBA_LENGTH, false);
+    double best = INFINITY, time;
+
+    trial.ntt_threshold = SIZE_MAX;
+    for (size_t i = 0; i < sizeof(karatsuba_cutoffs) /
+                           sizeof(karatsuba_cutoffs[0]); i++) {
+        trial.karatsuba_cutoff = karatsuba_cutoffs[i];
+        time = TimeMul(&p, &q, &trial);
+        if (time < best) {
+            best = time;
+            tuning->karatsuba_cutoff = karatsuba_cutoffs[i];
+        }
+    }
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+}
+
+/**
+ * Wyznacza najkrótszą długość czynników, od której NttMul jest szybsze
+ * od metody Karatsuby.
+ * @param[in] tuning : progi z dostrojoną metodą Karatsuby
+ * @param[in] small : czy współczynniki mają być małe (jedna liczba
+ * pierwsza), czy pełnego zakresu (NTT_PRIMES liczb pierwszych)?
+ * @return długość czynników lub 0, gdy NttMul nie okazało się szybsze
+ */
+static size_t NttCrossover(const PolyMulTuning *tuning, bool small)
+{
+    PolyMulTuning with = *tuning, without = *tuning;
+    double time_with, time_without;
+    Poly p, q;
+
+    with.ntt_threshold = 1;
+    with.ntt_prime_factor = 1;
+    without.ntt_threshold = SIZE_MAX;
+    for (size_t n = TUNE_NTT_MIN; n <= TUNE_NTT_MAX; n *= 2) {
+        p = DenseUnivariate(n, small);
+        q = DenseUnivariate(n, small);
+        time_with = TimeMul(&p, &q, &with);
+        time_without = TimeMul(&p, &q, &without);
+        PolyDestroy(&p);
+        PolyDestroy(&q);
+        if (time_with < time_without) {
+            return n;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Wyznacza progi NTT: próg dla jednej liczby pierwszej i czynnik, o który
+ * rośnie on z każdą kolejną liczbą pierwszą.
+ * @param[in] tuning : progi, do których wpisywany jest wynik
+ */
+static void TuneNtt(PolyMulTuning *tuning)
+{
+    size_t single = NttCrossover(tuning, true), full;
+
+    if (single == 0) {
+        tuning->ntt_threshold = SIZE_MAX;
+        return;
+    }
+    tuning->ntt_threshold = single;
+    full = NttCrossover(tuning, false);
+    if (full == 0) {
+        full = 2 * TUNE_NTT_MAX;
+    }
+    tuning->ntt_prime_factor = (size_t) ceil(sqrt((double) full / single));
+}
+
+/**
+ * Wyznacza najmniejszą liczbę iloczynów jednomianów, od której
+ * podstawienie Kroneckera jest szybsze od mnożenia kopcem.
+ * @param[in] tuning : progi, do których wpisywany jest wynik
+ */
+static void TuneKronecker(PolyMulTuning *tuning)
+{
+    PolyMulTuning with = *tuning, without = *tuning;
+    double time_with, time_without;
+    Poly p, q;
+
+    with.kronecker_min_products = 1;
+    without.kronecker_min_products = SIZE_MAX;
+    for (size_t k = 2; k <= TUNE_KRONECKER_MAX; k++) {
+        p = DenseBivariate(k);
+        q = DenseBivariate(k);
+        time_with = TimeMul(&p, &q, &with);
+        time_without = TimeMul(&p, &q, &without);
+        PolyDestroy(&p);
+        PolyDestroy(&q);
+        if (time_with < time_without) {
+            tuning->kronecker_min_products = k * k * k * k;
+            return;
+        }
+    }
+    tuning->kronecker_min_products = SIZE_MAX;
+}
+
+/**
+ * Wyznacza najmniejszą liczbę punktów, od której wartościowanie drzewem
+ * podiloczynów jest szybsze od schematu Hornera, dla wielomianu stopnia
+ * równego liczbie punktów.
+ * @param[in] tuning : progi z dostrojonym mnożeniem, do których wpisywany
+ * jest wynik
+ */
+static void TuneMultipoint(PolyMulTuning *tuning)
+{
+    PolyMulTuning with = *tuning, without = *tuning;
+    double time_with, time_without;
+    poly_coeff_t *xs, *out;
+    Poly p;
+
+    with.multipoint_threshold = 1;
+    without.multipoint_threshold = SIZE_MAX;
+    xs = (poly_coeff_t*) malloc(sizeof(poly_coeff_t) * TUNE_MULTIPOINT_MAX);
+    out = (poly_coeff_t*) malloc(sizeof(poly_coeff_t) * TUNE_MULTIPOINT_MAX);
+    for (size_t i = 0; i < TUNE_MULTIPOINT_MAX; i++) {
+        xs[i] = RandomCoeff(false);
+    }
+    tuning->multipoint_threshold = SIZE_MAX;
+    for (size_t k = TUNE_MULTIPOINT_MIN; k <= TUNE_MULTIPOINT_MAX; k *= 2) {
+        p = DenseUnivariate(k, false);
+        time_with = TimeAtMany(&p, k, xs, out, &with);
+        time_without = TimeAtMany(&p, k, xs, out, &without);
+        PolyDestroy(&p);
+        if (time_with < time_without) {
+            tuning->multipoint_threshold = k;
+            break;
+        }
+    }
+    free(xs);
+    free(out);
+}
+
+/**
+ * Stroi progi wyboru algorytmu mnożenia i zapisuje je do pliku.
+ * @param[in] argc : liczba argumentów
+ * @param[in] argv : argumenty, argv[1] to ścieżka pliku progów
+ * @return 0 w przypadku powodzenia, 1 w przeciwnym razie
+ */
+int main(int argc, char *argv[])
+{
+    PolyMulTuning tuning = PolyMulGetTuning();
+
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s TUNING_FILE\n", argv[0]);
+        return 1;
+    }
+    srand(1);
+    TuneKaratsuba(&tuning);
+    TuneNtt(&tuning);
+    TuneKronecker(&tuning);
+    TuneMultipoint(&tuning);
+    PolyMulSetTuning(&tuning);
+    RegionReleaseAll();
+    MemPoolReleaseAll();
+    if (!PolyMulSaveTuning(argv[1])) {
+        fprintf(stderr, "cannot write %s\n", argv[1]);
+        return 1;
+    }
+    printf("karatsuba_cutoff %zu\nntt_threshold %zu\nntt_prime_factor %zu\n"
+           "kronecker_min_products %zu\nmultipoint_threshold %zu\n",
+           tuning.karatsuba_cutoff, tuning.ntt_threshold,
+           tuning.ntt_prime_factor, tuning.kronecker_min_products,
+           tuning.multipoint_threshold);
+    return 0;
+}
@@ -0,0 +1,330 @@
+/** @file
+   Wartościowanie wielomianów w wielu punktach naraz
+
+   Pętle po punktach bloku napisane są raz, jako funkcje rozwijane
+   w miejscu wywołania, i kompilowane osobno dla każdego wariantu
+   instrukcji, dzięki czemu kompilator zamienia je na operacje na
+   rejestrach AVX-512 albo AVX2. Punkty bloku przechodzą schemat Hornera
+   w jednym kroku, więc lista jednomianów czytana jest raz na blok.
+
+   @author Piotr Szuberski <p.szuberski@student.uw.edu.pl>,
+   @copyright Uniwersytet Warszawski
+   @date 2026-10-18,
+*/
+
+#include "batch_eval.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+/** Czy dostępne są warianty AVX-512 i AVX2? */
+#define BATCH_X86
+/** Atrybut funkcji kompilowanej dla AVX-512 */
+#define BATCH_TARGET_AVX512 __attribute__((target("avx512f,avx512dq")))
+/** Atrybut funkcji kompilowanej dla AVX2 */
+#define BATCH_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+#ifdef __GNUC__
+/** Treści funkcji muszą być rozwinięte w każdym wariancie instrukcji */
+#define BATCH_INLINE static inline __attribute__((always_inline))
+#else
+/** Treści funkcji muszą być rozwinięte w każdym wariancie instrukcji */
+#define BATCH_INLINE static inline
+#endif
+
+/** Liczba punktów liczonych w jednym przejściu po jednomianach */
+#define BATCH_BLOCK 32
+
+/**
+ * Zbiór funkcji jednego wariantu instrukcji
+ */
+typedef struct BatchKernels {
+    /** horner : zob. BatchHorner */
+    void (*horner)(const unsigned long coeffs[], const int exps[],
+                   unsigned count, size_t k, const unsigned long xs[],
+                   unsigned long out[]);
+    /** power_step : zob. BatchPowerStep */
+    void (*power_step)(size_t k, const unsigned long xs[], unsigned gap,
+                       unsigned long pw[]);
+    /** mul_add : zob. BatchMulAdd */
+    void (*mul_add)(size_t k, const unsigned long pw[],
+                    const unsigned long v[], unsigned long out[]);
+    /** mul_add_coeff : zob. BatchMulAddCoeff */
+    void (*mul_add_coeff)(size_t k, const unsigned long pw[],
+                          unsigned long c, unsigned long out[]);
+} BatchKernels;
+
+/**
+ * Potęguje punkty bloku przez podnoszenie do kwadratu, ten sam wykładnik
+ * dla wszystkich punktów.
+ * @param[in] m : liczba punktów, najwyżej BATCH_BLOCK
+ * @param[in] x : punkty
+ * @param[in] e : wykładnik
+ * @param[out] out : `x[j]^e`
+ */
+BATCH_INLINE void BatchPowerBlock(size_t m, const unsigned long x[],
+                                  unsigned e, unsigned long out[])
+{
+    unsigned long base[BATCH_BLOCK];
+
+    for (size_t j = 0; j < m; j++) {
+        out[j] = 1;
+        base[j] = x[j];
+    }
+    while (e > 0) {
+        if (e % 2 == 1) {
+            for (size_t j = 0; j < m; j++) {
+                out[j] *= base[j];
+            }
+        }
+        e /= 2;
+        if (e > 0) {
+            for (size_t j = 0; j < m; j++) {
+                base[j] *= base[j];
+            }
+        }
+    }
+}
+
+/**
+ * Schemat Hornera dla bloku punktów, od najwyższego wykładnika. Potęga
+ * punktów o różnicę wykładników liczona jest tylko, gdy różnica się
+ * zmienia.
+ * @param[in] coeffs : współczynniki jednomianów
+ * @param[in] exps : wykładniki jednomianów, ściśle rosnące
+ * @param[in] count : liczba jednomianów, dodatnia
+ * @param[in] m : liczba punktów, najwyżej BATCH_BLOCK
+ * @param[in] x : punkty
+ * @param[out] out : wartości w punktach
+ */
+BATCH_INLINE void BatchHornerBlock(const unsigned long coeffs[],
+                                   const int exps[], unsigned count,
+                                   size_t m, const unsigned long x[],
+                                   unsigned long out[])
+{
+    unsigned long value[BATCH_BLOCK], xp[BATCH_BLOCK];
+    unsigned gap = 0, current;
+
+    for (size_t j = 0; j < m; j++) {
+        value[j] = coeffs[count - 1];
+    }
+    for (unsigned i = count - 1; i > 0; i--) {
+        current = (unsigned) (exps[i] - exps[i - 1]);
+        if (current != gap) {
+            BatchPowerBlock(m, x, current, xp);
+            gap = current;
+        }
+        for (size_t j = 0; j < m; j++) {
+            value[j] = value[j] * xp[j] + coeffs[i - 1];
+        }
+    }
+    if (exps[0] > 0) {
+        BatchPowerBlock(m, x, (unsigned) exps[0], xp);
+        for (size_t j = 0; j < m; j++) {
+            value[j] *= xp[j];
+        }
+    }
+    for (size_t j = 0; j < m; j++) {
+        out[j] = value[j];
+    }
+}
+
+/**
+ * Treść BatchHorner, dzieli punkty na bloki.
+ */
+BATCH_INLINE void BatchHornerBody(const unsigned long coeffs[],
+                                  const int exps[], unsigned count,
+                                  size_t k, const unsigned long xs[],
+                                  unsigned long out[])
+{
+    for (size_t s = 0; s < k; s += BATCH_BLOCK) {
+        BatchHornerBlock(coeffs, exps, count,
+                         k - s < BATCH_BLOCK ? k - s : BATCH_BLOCK,
+                         xs + s, out + s);
+    }
+}
+
+/**
+ * Treść BatchPowerStep, dzieli punkty na bloki.
+ */
+BATCH_INLINE void BatchPowerStepBody(size_t k, const unsigned long xs[],
+                                     unsigned gap, unsigned long pw[])
+{
+    unsigned long xp[BATCH_BLOCK];
+    size_t m;
+
+    for (size_t s = 0; s < k; s += BATCH_BLOCK) {
+        m = k - s < BATCH_BLOCK ? k - s : BATCH_BLOCK;
+        BatchPowerBlock(m, xs + s, gap, xp);
+        for (size_t j = 0; j < m; j++) {
+            pw[s + j] *= xp[j];
+        }
+    }
+}
+
+/**
+ * Treść BatchMulAdd.
+ */
+BATCH_INLINE void BatchMulAddBody(size_t k, const unsigned long pw[],
+                                  const unsigned long v[],
+                                  unsigned long out[])
+{
+    for (size_t j = 0; j < k; j++) {
+        out[j] += pw[j] * v[j];
+    }
+}
+
+/**
+ * Treść BatchMulAddCoeff.
+ */
+BATCH_INLINE void BatchMulAddCoeffBody(size_t k, const unsigned long pw[],
+                                       unsigned long c, unsigned long out[])
+{
+    for (size_t j = 0; j < k; j++) {
+        out[j] += pw[j] * c;
+    }
+}
+
+/**
+ * Definiuje funkcje jednego wariantu instrukcji, kompilując treści
+ * z atrybutem @p attr, oraz ich zbiór @p kernels.
+ */
+#define BATCH_DEFINE_KERNELS(suffix, attr, kernels) \
+    attr static void BatchHorner##suffix(const unsigned long coeffs[], \
+                                         const int exps[], unsigned count, \
+                                         size_t k, const unsigned long xs[], \
+                                         unsigned long out[]) \
+    { \
+        BatchHornerBody(coeffs, exps, count, k, xs, out); \
+    } \
+    attr static void BatchPowerStep##suffix(size_t k, \
+                                            const unsigned long xs[], \
+                                            unsigned gap, unsigned long pw[]) \
+    { \
+        BatchPowerStepBody(k, xs, gap, pw); \
+    } \
+    attr static void BatchMulAdd##suffix(size_t k, const unsigned long pw[], \
+                                         const unsigned long v[], \
+                                         unsigned long out[]) \
+    { \
+        BatchMulAddBody(k, pw, v, out); \
+    } \
+    attr static void BatchMulAddCoeff##suffix(size_t k, \
+                                              const unsigned long pw[], \
+                                              unsigned long c, \
+                                              unsigned long out[]) \
+    { \
+        BatchMulAddCoeffBody(k, pw, c, out); \
+    } \
+    static const BatchKernels kernels = { \
+        BatchHorner##suffix, BatchPowerStep##suffix, \
+        BatchMulAdd##suffix, BatchMulAddCoeff##suffix \
+    };
+
+BATCH_DEFINE_KERNELS(Generic, , batch_generic)
+
+#ifdef BATCH_X86
+BATCH_DEFINE_KERNELS(Avx2, BATCH_TARGET_AVX2, batch_avx2)
+BATCH_DEFINE_KERNELS(Avx512, BATCH_TARGET_AVX512, batch_avx512)
+#endif
+
+/** Wybrany wariant instrukcji, NULL przed pierwszym wywołaniem */
+static const BatchKernels *batch_selected = NULL;
+
+/**
+ * Podaje zbiór funkcji wariantu, jeśli procesor go obsługuje.
+ * @param[in] variant : wariant, BATCH_AUTO to najszerszy obsługiwany
+ * @return zbiór funkcji albo NULL, gdy wariant nie jest obsługiwany
+ */
+static const BatchKernels *BatchKernelsOf(enum BatchVariant variant)
+{
+    bool avx512 = false, avx2 = false;
+
+#ifdef BATCH_X86
+    __builtin_cpu_init();
+    avx512 = __builtin_cpu_supports("avx512f") &&
+             __builtin_cpu_supports("avx512dq");
+    avx2 = __builtin_cpu_supports("avx2");
+#endif
+    if (variant == BATCH_AUTO) {
+        variant = avx512 ? BATCH_AVX512 : avx2 ? BATCH_AVX2 : BATCH_GENERIC;
+    }
+    switch (variant) {
+        case BATCH_GENERIC:
+            return &batch_generic;
+#ifdef BATCH_X86
+        case BATCH_AVX2:
+            return avx2 ? &batch_avx2 : NULL;
+        case BATCH_AVX512:
+            return avx512 ? &batch_avx512 : NULL;
+#endif
+        default:
+            return NULL;
+    }
+}
+
+/**
+ * Wybiera przy pierwszym wywołaniu najszerszy wariant instrukcji
+ * obsługiwany przez procesor.
+ * @return zbiór funkcji wybranego wariantu
+ */
+static const BatchKernels *BatchSelect(void)
+{
+    if (batch_selected == NULL) {
+        batch_selected = BatchKernelsOf(BATCH_AUTO);
+    }
+    return batch_selected;
+}
+
+bool BatchSetVariant(enum BatchVariant variant)
+{
+    const BatchKernels *kernels = BatchKernelsOf(variant);
+
+    if (kernels == NULL) {
+        return false;
+    }
+    batch_selected = kernels;
+    return true;
+}
+
+enum BatchVariant BatchGetVariant(void)
+{
+    const BatchKernels *kernels = BatchSelect();
+
+#ifdef BATCH_X86
+    if (kernels == &batch_avx512) {
+        return BATCH_AVX512;
+    }
+    if (kernels == &batch_avx2) {
+        return BATCH_AVX2;
+    }
+#endif
+    (void) kernels;
+    return BATCH_GENERIC;
+}
+
+void BatchHorner(const unsigned long coeffs[], const int exps[],
+                 unsigned count, size_t k, const unsigned long xs[],
+                 unsigned long out[])
+{
+    BatchSelect()->horner(coeffs, exps, count, k, xs, out);
+}
+
+void BatchPowerStep(size_t k, const unsigned long xs[], unsigned gap,
+                    unsigned long pw[])
+{
+    if (gap > 0) {
+        BatchSelect()->power_step(k, xs, gap, pw);
+    }
+}
+
+void BatchMulAdd(size_t k, const unsigned long pw[], const unsigned long v[],
+                 unsigned long out[])
+{
+    BatchSelect()->mul_add(k, pw, v, out);
+}
+
+void BatchMulAddCoeff(size_t k, const unsigned long pw[], unsigned long c,
+                      unsigned long out[])
+{
+    BatchSelect()->mul_add_coeff(k, pw, c, out);
+}
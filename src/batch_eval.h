@@ -0,0 +1,94 @@
+/** @file
+   Interfejs wartościowania wielomianów w wielu punktach naraz
+
+   Funkcje liczą tę samą wartość dla wielu punktów jednocześnie: jedno
+   przejście po jednomianach obsługuje cały blok punktów, a operacje na
+   punktach bloku wykonywane są równolegle na rejestrach wektorowych.
+   Wariant instrukcji (AVX-512, AVX2 lub zwykły kod) wybierany jest przy
+   pierwszym wywołaniu na podstawie możliwości procesora, chyba że został
+   wymuszony funkcją BatchSetVariant. Arytmetyka jest
+   modulo 2^64, więc wyniki są identyczne we wszystkich wariantach
+   i z wartościowaniem pojedynczych punktów.
+
+   @author Piotr Szuberski <p.szuberski@student.uw.edu.pl>,
+   @copyright Uniwersytet Warszawski
+   @date 2026-10-18,
+*/
+
+#ifndef WIELOMIANY_BATCH_EVAL_H
+#define WIELOMIANY_BATCH_EVAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Wariant instrukcji funkcji wartościowania
+ */
+enum BatchVariant {
+    BATCH_AUTO,    /**< najszerszy wariant obsługiwany przez procesor */
+    BATCH_GENERIC, /**< zwykły kod, bez atrybutów wektorowych */
+    BATCH_AVX2,    /**< kod kompilowany dla AVX2 */
+    BATCH_AVX512   /**< kod kompilowany dla AVX-512 */
+};
+
+/**
+ * Wymusza wariant instrukcji kolejnych wywołań funkcji wartościowania,
+ * np. żeby porównać warianty między sobą. BATCH_AUTO przywraca wybór na
+ * podstawie możliwości procesora.
+ * @param[in] variant : wariant
+ * @return czy procesor obsługuje wariant? W przeciwnym razie wariant
+ * pozostaje bez zmian.
+ */
+bool BatchSetVariant(enum BatchVariant variant);
+
+/**
+ * Podaje wariant instrukcji używany przez funkcje wartościowania.
+ * @return wariant, nigdy BATCH_AUTO
+ */
+enum BatchVariant BatchGetVariant(void);
+
+/**
+ * Wylicza schematem Hornera wartości wielomianu jednej zmiennej
+ * o stałych współczynnikach w @p k punktach.
+ * @param[in] coeffs : współczynniki jednomianów
+ * @param[in] exps : wykładniki jednomianów, ściśle rosnące
+ * @param[in] count : liczba jednomianów, dodatnia
+ * @param[in] k : liczba punktów
+ * @param[in] xs : punkty
+ * @param[out] out : wartości w punktach, tablica długości @p k
+ */
+void BatchHorner(const unsigned long coeffs[], const int exps[],
+                 unsigned count, size_t k, const unsigned long xs[],
+                 unsigned long out[]);
+
+/**
+ * Mnoży potęgi punktów przez te same punkty w potędze @p gap.
+ * @param[in] k : liczba punktów
+ * @param[in] xs : punkty
+ * @param[in] gap : wykładnik
+ * @param[in,out] pw : potęgi punktów, zastępowane przez `pw[j] * xs[j]^gap`
+ */
+void BatchPowerStep(size_t k, const unsigned long xs[], unsigned gap,
+                    unsigned long pw[]);
+
+/**
+ * Dodaje do wartości iloczyny potęg punktów i wartości współczynnika.
+ * @param[in] k : liczba punktów
+ * @param[in] pw : potęgi punktów
+ * @param[in] v : wartości współczynnika w punktach
+ * @param[in,out] out : wartości, zastępowane przez `out[j] + pw[j] * v[j]`
+ */
+void BatchMulAdd(size_t k, const unsigned long pw[], const unsigned long v[],
+                 unsigned long out[]);
+
+/**
+ * Dodaje do wartości iloczyny potęg punktów i stałego współczynnika.
+ * @param[in] k : liczba punktów
+ * @param[in] pw : potęgi punktów
+ * @param[in] c : współczynnik
+ * @param[in,out] out : wartości, zastępowane przez `out[j] + pw[j] * c`
+ */
+void BatchMulAddCoeff(size_t k, const unsigned long pw[], unsigned long c,
+                      unsigned long out[]);
+
+#endif //WIELOMIANY_BATCH_EVAL_H
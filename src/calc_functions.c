@@ -10,6 +10,7 @@
 #include <limits.h>
 #include <memory.h>
 #include "utils.h"
+#include "mem_pool.h"
 #include "calc_functions.h"
 
 /**
@@ -19,6 +20,61 @@
  */
 static void ExpandPoly(Poly **polys, unsigned *length);
 
+/**
+ * Parsuje wartość zmiennej w formacie komendy AT: opcjonalny minus
+ * i cyfry, bez zer wiodących, w zakresie poly_coeff_t
+ * @param[in] input : napis z wartością
+ * @param[in] length : długość wartości w napisie
+ * @param[out] value : odczytana wartość
+ * @return 'czy wartość jest poprawna?'
+ */
+static bool ParseValue(const char *input, size_t length, poly_coeff_t *value);
+
+/**
+ * Plan wartościowania wielomianu z wierzchu stosu, współdzielony przez
+ * kolejne komendy AT i EVAL. Wielomian trzymany jest z własną referencją,
+ * więc jego poziomy nie mogą zostać zwolnione ani zmienione w miejscu,
+ * a ten sam wskaźnik na szczycie stosu oznacza ten sam wielomian.
+ * Referencja oddawana jest, gdy wielomian schodzi ze stosu (zob.
+ * EvalCacheRelease), bo inaczej ADD, SUB i NEG kopiowałyby poziom zamiast
+ * zmieniać go w miejscu, a POP nie zwalniałby pamięci.
+ */
+typedef struct EvalCache {
+    Poly source; /**< source : wielomian, którego dotyczy plan */
+    PolyEvalPlan plan; /**< plan : plan, ważny gdy compiled */
+    bool filled; /**< filled : czy source jest ustawiony? */
+    bool compiled; /**< compiled : czy plan został skompilowany? */
+} EvalCache;
+
+/** Plan wartościowania współdzielony przez komendy AT i EVAL */
+static EvalCache eval_cache = {.filled = false, .compiled = false};
+
+/**
+ * Zwraca plan wartościowania wielomianu. Plan kompilowany jest przy
+ * drugim z kolei wartościowaniu tego samego wielomianu, więc jednorazowe
+ * wartościowanie nie płaci za kompilację.
+ * @param[in] p : wielomian z wierzchu stosu, niebędący stałą
+ * @return plan lub NULL, gdy wielomian wartościowany jest pierwszy raz
+ */
+static const PolyEvalPlan *EvalCachePlan(const Poly *p);
+
+/**
+ * Sprawdza, czy plan wartościowania dotyczy wielomianu @p p.
+ * @param[in] p : wielomian
+ * @return czy @p p ma te same poziomy co wielomian planu?
+ */
+static bool EvalCacheHolds(const Poly *p);
+
+/**
+ * Zwalnia plan wartościowania razem z referencją do wielomianu, gdy
+ * zdjęty ze stosu wielomian @p p jest wielomianem planu, a nowy wierzch
+ * stosu nim nie jest. Jeśli wierzch jest kopią zdjętego wielomianu
+ * (np. po CLONE), plan pozostaje do kolejnych komend AT i EVAL.
+ * @param[in] p : wielomian zdjęty ze stosu
+ * @param[in] ps : stos po zdjęciu wielomianu
+ */
+static void EvalCacheRelease(const Poly *p, const PolyStack *ps);
+
 void Add(int line, PolyStack **ps)
 {
     Poly poly_p, poly_q, poly_result;
@@ -27,9 +83,9 @@ void Add(int line, PolyStack **ps)
         poly_p = PolyStackPop(ps);
         if (!PolyStackIsEmpty(*ps)) {
             poly_q = PolyStackPop(ps);
-            poly_result = PolyAdd(&poly_p, &poly_q);
-            PolyDestroy(&poly_p);
-            PolyDestroy(&poly_q);
+            EvalCacheRelease(&poly_p, *ps);
+            EvalCacheRelease(&poly_q, *ps);
+            poly_result = PolyAddOwned(&poly_p, &poly_q);
             PolyStackPush(ps, poly_result);
         }
         else {
@@ -64,9 +120,9 @@ void Mul(int line, PolyStack **ps)
         poly_p = PolyStackPop(ps);
         if (!PolyStackIsEmpty(*ps)) {
             poly_q = PolyStackPop(ps);
-            poly_result = PolyMul(&poly_p, &poly_q);
-            PolyDestroy(&poly_p);
-            PolyDestroy(&poly_q);
+            EvalCacheRelease(&poly_p, *ps);
+            EvalCacheRelease(&poly_q, *ps);
+            poly_result = PolyMulOwned(&poly_p, &poly_q);
             PolyStackPush(ps, poly_result);
         }
         else {
@@ -82,13 +138,13 @@ void Mul(int line, PolyStack **ps)
 
 void Neg(int line, PolyStack **ps)
 {
-    Poly poly_p, poly_result;
+    Poly poly_p;
 
     if (!PolyStackIsEmpty(*ps)) {
         poly_p = PolyStackPop(ps);
-        poly_result = PolyNeg(&poly_p);
-        PolyDestroy(&poly_p);
-        PolyStackPush(ps, poly_result);
+        EvalCacheRelease(&poly_p, *ps);
+        PolyNegInPlace(&poly_p);
+        PolyStackPush(ps, poly_p);
     }
     else {
         ErrorStackUnderflow(line);
@@ -103,9 +159,9 @@ void Sub(int line, PolyStack **ps)
         poly_p = PolyStackPop(ps);
         if (!PolyStackIsEmpty(*ps)) {
             poly_q = PolyStackPop(ps);
-            poly_result = PolySub(&poly_p, &poly_q);
-            PolyDestroy(&poly_p);
-            PolyDestroy(&poly_q);
+            EvalCacheRelease(&poly_p, *ps);
+            EvalCacheRelease(&poly_q, *ps);
+            poly_result = PolySubOwned(&poly_p, &poly_q);
             PolyStackPush(ps, poly_result);
         }
         else {
@@ -191,12 +247,44 @@ void Print(int line, const PolyStack *ps)
     }
 }
 
+void Mem(int line, const PolyStack *ps)
+{
+    Poly poly_p, *polys;
+    PolyMemInfo top, total;
+    MemPoolStats pool;
+    size_t count = 0;
+    const PolyStack *helper;
+
+    (void) line;
+    if (!PolyStackIsEmpty(ps)) {
+        poly_p = PolyStackTop(ps);
+        top = PolyMemStats(&poly_p);
+        printf("TOP nodes=%zu depth=%u leaves=%zu bytes=%zu\n",
+               top.nodes, top.depth, top.leaves, top.bytes);
+    }
+    for (helper = ps; !PolyStackIsEmpty(helper); helper = helper->next) {
+        count++;
+    }
+    polys = (Poly*) RegionAlloc(sizeof(Poly) * count);
+    count = 0;
+    for (helper = ps; !PolyStackIsEmpty(helper); helper = helper->next) {
+        polys[count++] = helper->p;
+    }
+    total = PolyMemStatsMany(count, polys);
+    printf("STACK polys=%zu nodes=%zu depth=%u leaves=%zu bytes=%zu\n",
+           count, total.nodes, total.depth, total.leaves, total.bytes);
+    pool = MemPoolGetStats();
+    printf("POOL live=%zu peak=%zu allocs=%zu\n",
+           pool.live_bytes, pool.peak_bytes, pool.allocs);
+}
+
 void Pop(int line, PolyStack **ps)
 {
     Poly poly_p;
 
     if (!PolyStackIsEmpty(*ps)) {
         poly_p = PolyStackPop(ps);
+        EvalCacheRelease(&poly_p, *ps);
         PolyDestroy(&poly_p);
     }
     else {
@@ -234,6 +322,7 @@ void At(const char *input, int line, PolyStack **ps)
     char at_string[length - 3 + 1];
     char comparator[LMIN_LENGTH + 1];
     poly_coeff_t at_value;
+    const PolyEvalPlan *plan;
     Poly poly_p, poly_result;
 
     if (!PolyStackIsEmpty(*ps)) {
@@ -257,7 +346,12 @@ void At(const char *input, int line, PolyStack **ps)
                 sprintf(comparator, "%ld", at_value);
                 if (strcmp(comparator, at_string) == 0) {
                     poly_p = PolyStackPop(ps);
-                    poly_result = PolyAt(&poly_p, at_value);
+                    plan = poly_p.tag == LEAF ? EvalCachePlan(&poly_p) : NULL;
+                    poly_result = plan != NULL ?
+                                  PolyFromCoeff(PolyEvalCompiled(plan, 1,
+                                                                 &at_value)) :
+                                  PolyAt(&poly_p, at_value);
+                    EvalCacheRelease(&poly_p, *ps);
                     PolyDestroy(&poly_p);
                     PolyStackPush(ps, poly_result);
                 }
@@ -278,11 +372,123 @@ void At(const char *input, int line, PolyStack **ps)
     }
 }
 
+static bool ParseValue(const char *input, size_t length, poly_coeff_t *value)
+{
+    char value_string[LMIN_LENGTH + 1];
+    char comparator[LMIN_LENGTH + 1];
+    size_t i = (length > 0 && input[0] == '-') ? 1 : 0;
+
+    if (length == 0 || length > LMIN_LENGTH) {
+        return false;
+    }
+    for (; i < length; i++) {
+        if (input[i] < '0' || input[i] > '9') {
+            return false;
+        }
+    }
+    memcpy(value_string, input, length);
+    value_string[length] = END;
+    *value = atol(value_string);
+    sprintf(comparator, "%ld", *value);
+    return strcmp(comparator, value_string) == 0;
+}
+
+void Eval(const char *input, int line, const PolyStack *ps)
+{
+    size_t length = strlen(input), index = 4, start;
+    unsigned count = 0;
+    bool correct = length > index;
+    poly_coeff_t *xs;
+    const PolyEvalPlan *plan;
+    Poly poly_p;
+
+    if (!PolyStackIsEmpty(ps)) {
+        xs = (poly_coeff_t*) RegionAlloc(sizeof(poly_coeff_t) * (length / 2));
+        while (correct && index < length) {
+            if (input[index] == SPACE) {
+                start = ++index;
+                while (index < length && input[index] != SPACE) {
+                    index++;
+                }
+                correct = ParseValue(input + start, index - start, &xs[count]);
+                count++;
+            }
+            else {
+                correct = false;
+            }
+        }
+        if (correct) {
+            poly_p = PolyStackTop(ps);
+            plan = PolyIsCoeff(&poly_p) ? NULL : EvalCachePlan(&poly_p);
+            printf("%ld\n", plan != NULL ? PolyEvalCompiled(plan, count, xs) :
+                                            PolyEval(&poly_p, count, xs));
+        }
+        else {
+            ErrorCorruptedEval(line);
+        }
+    }
+    else {
+        ErrorStackUnderflow(line);
+    }
+}
+
+static bool EvalCacheHolds(const Poly *p)
+{
+    const Poly *source = &eval_cache.source;
+
+    return eval_cache.filled && source->tag == p->tag &&
+           (p->tag == LEAF ? source->type.l == p->type.l :
+                             source->type.m == p->type.m);
+}
+
+static void EvalCacheRelease(const Poly *p, const PolyStack *ps)
+{
+    Poly top;
+
+    if (EvalCacheHolds(p)) {
+        if (!PolyStackIsEmpty(ps)) {
+            top = PolyStackTop(ps);
+            if (EvalCacheHolds(&top)) {
+                return;
+            }
+        }
+        EvalCacheClear();
+    }
+}
+
+static const PolyEvalPlan *EvalCachePlan(const Poly *p)
+{
+    if (EvalCacheHolds(p)) {
+        if (!eval_cache.compiled) {
+            eval_cache.plan = PolyCompileEval(p);
+            eval_cache.compiled = true;
+        }
+        return &eval_cache.plan;
+    }
+    EvalCacheClear();
+    eval_cache.source = PolyClone(p);
+    eval_cache.filled = true;
+    return NULL;
+}
+
+void EvalCacheClear(void)
+{
+    if (eval_cache.compiled) {
+        PolyEvalPlanDestroy(&eval_cache.plan);
+        eval_cache.compiled = false;
+    }
+    if (eval_cache.filled) {
+        PolyDestroy(&eval_cache.source);
+        eval_cache.filled = false;
+    }
+}
+
 static void ExpandPoly(Poly **polys, unsigned *length)
 {
     unsigned prev_size = *length;
     *length *= 2;
-    *polys = (Poly*) realloc(*polys, sizeof(Poly) * (*length));
+    *polys = (Poly*) RegionRealloc(*polys, sizeof(Poly) * prev_size,
+                                   sizeof(Poly) * (*length));
     for (unsigned i = prev_size; i < *length; i++) {
         (*polys)[i] = PolyZero();
     }
@@ -303,7 +509,7 @@ void Compose(const char *input, int line, PolyStack **ps)
          input[c] == END) && !PolyStackIsEmpty(*ps)) {
         if  (compose_value < UINT_MAX) {
             poly_p = PolyStackPop(ps);
-            polys = (Poly *) malloc(sizeof(Poly) * polys_length);
+            polys = (Poly *) RegionAlloc(sizeof(Poly) * polys_length);
             fader = (unsigned) compose_value;
             while (go_on && fader > 0) {
                 if (!PolyStackIsEmpty(*ps)) {
@@ -319,18 +525,19 @@ void Compose(const char *input, int line, PolyStack **ps)
             }
             if (go_on) {
                 poly_result = PolyCompose(&poly_p, count, polys);
-                PolyStackPush(ps, poly_result);
                 for (unsigned i = 0; i < count; i++) {
+                    EvalCacheRelease(&polys[i], *ps);
                     PolyDestroy(&polys[i]);
                 }
+                EvalCacheRelease(&poly_p, *ps);
                 PolyDestroy(&poly_p);
+                PolyStackPush(ps, poly_result);
             } else {
                 for (long i = (long) count - 1; i >= 0; i--) {
                     PolyStackPush(ps, polys[i]);
                 }
                 PolyStackPush(ps, poly_p);
             }
-            free(polys);
         }
         else {
             ErrorStackUnderflow(line);
@@ -81,6 +81,15 @@ void Deg(int line, const PolyStack *ps);
  */
 void Print(int line, const PolyStack *ps);
 
+/**
+ * Wypisuje pamięć zajmowaną przez wielomian z wierzchu stosu, sumę dla
+ * całego stosu oraz liczniki puli pamięci. Na pustym stosie wypisuje
+ * tylko sumę dla stosu i liczniki puli.
+ * @param[in] line : numer aktualnego wiersza
+ * @param[in] ps : stos wielomianów
+ */
+void Mem(int line, const PolyStack *ps);
+
 /**
  * Usuwa wielomian z wierzchu stosu
  * @param[in] line : numer aktualnego wiersza
@@ -96,6 +105,21 @@ void Pop(int line, PolyStack **ps);
  */
 void At(const char *input, int line, PolyStack **ps);
 
+/**
+ * Wypisuje wartość wielomianu z wierzchu stosu w punkcie podanym jako
+ * wartości kolejnych zmiennych, bez zdejmowania go ze stosu
+ * @param[in] input : napis z wartościami zmiennych oddzielonymi spacjami
+ * @param[in] line : numer aktualnego wiersza
+ * @param[in] ps : stos wielomianów
+ */
+void Eval(const char *input, int line, const PolyStack *ps);
+
+/**
+ * Zwalnia plan wartościowania zapamiętany przez komendy AT i EVAL
+ * razem z referencją do wartościowanego wielomianu
+ */
+void EvalCacheClear(void);
+
 /**
  * Podaje stopień wielomianu na określonej głębokości
  * @param[in] input : napis z wartością głębokości wielomianu
@@ -8,15 +8,17 @@
 #include <strings.h>
 #include <memory.h>
 #include <stdlib.h>
+#include <pthread.h>
 #include "utils.h"
+#include "mem_pool.h"
+#include "region.h"
 #include "calc_poly.h"
 #include "calc_functions.h"
 
 
 char *ExtractNumber(int *index, size_t *new_length, char *c)
 {
-    char *number = (char*) malloc(sizeof(char) * (START + 1));
-    assert(number != NULL);
+    char *number = (char*) RegionAlloc(sizeof(char) * (START + 1));
     unsigned int i = 0;
 
     *new_length = START;
@@ -38,7 +40,6 @@ char *ExtractNumber(int *index, size_t *new_length, char *c)
     number[i] = END;
     *new_length = (size_t) i;
     if (i == 0 || (i == 1 && number[0] == '-')) {
-        free(number);
         return NULL;
     }
     else {
@@ -53,24 +54,16 @@ bool ParseExp(char *input, poly_exp_t *exp)
     char *comparator;
 
     if (length == 0 || input[0] == '-' || length > IMAX_LENGTH) {
-        if (length > 0) {
-            free(input);
-        }
         return false;
     }
-    comparator = (char*) malloc(sizeof(char) * (length + 1));
-    assert(comparator != NULL);
+    comparator = (char*) RegionAlloc(sizeof(char) * (length + 1));
     value = atoi(input);
     sprintf(comparator, "%d", value);
     if (strcmp(comparator, input) == 0) {
         *exp = (poly_exp_t) value;
-        free(comparator);
-        free(input);
         return true;
     }
     else {
-        free(input);
-        free(comparator);
         return false;
     }
 }
@@ -87,22 +80,16 @@ bool ParseCoeff(char *input, poly_coeff_t *coeff, bool *minus)
                 input[1] > '9' && input[1] < '0')) ||
         (input[0] == '-' && length > 20) ||
         (input[0] >= '0' && input[0] <= '9' && length > 19)) {
-        free(input);
         return false;
     }
     value = atol(input);
-    comparator = (char*) malloc(sizeof(char) * (length + 1));
-    assert(comparator != NULL);
+    comparator = (char*) RegionAlloc(sizeof(char) * (length + 1));
     sprintf(comparator, "%ld", value);
     if (strcmp(input, comparator) == 0 || strcmp(input, "-0") == 0) {
         *coeff = value;
-        free(input);
-        free(comparator);
         return true;
     }
     else {
-        free(input);
-        free(comparator);
         return false;
     }
 }
@@ -218,13 +205,11 @@ void ClosingBracketCase(char *c, int line, int *column, bool *go_on,
         if (*c == NEW_LINE || *c == EOF || *c == ',') {
             i = 0;
             mono_length = 1;
-            monos = (Mono*) malloc(sizeof(Mono) * mono_length);
-            assert(monos != NULL);
+            monos = (Mono*) RegionAlloc(sizeof(Mono) * mono_length);
             if (!MonoStackIsEmpty(*ms)) {
                 monos[i++] = MonoStackPop(ms);
             }
             else {
-                free(monos);
                 *go_on = ErrorParsingPoly(line, *column);
             }
             while (*go_on && !DigitStackIsEmpty(*ds) &&
@@ -232,15 +217,14 @@ void ClosingBracketCase(char *c, int line, int *column, bool *go_on,
                 DigitStackPop(ds);
                 if (!MonoStackIsEmpty(*ms)) {
                     if (i == mono_length) {
+                        monos = (Mono*) RegionRealloc(monos,
+                                                mono_length * sizeof(Mono),
+                                                2 * mono_length * sizeof(Mono));
                         mono_length = 2 * mono_length;
-                        monos = (Mono*) realloc(monos,
-                                                mono_length * sizeof(Mono));
-                        assert(monos != NULL);
                     }
                     monos[i++] = MonoStackPop(ms);
                 }
                 else {
-                    free(monos);
                     *go_on = ErrorParsingPoly(line, *column);
                 }
             }
@@ -248,7 +232,6 @@ void ClosingBracketCase(char *c, int line, int *column, bool *go_on,
             if (*go_on) {
                 poly = PolyAddMonos(mono_length, monos);
                 PolyStackPush(ps, poly);
-                free(monos);
             }
         }
         else if (*c != '+') {
@@ -321,9 +304,8 @@ bool ParsePoly(Poly *p, int line, char c)
 
 void Expand(char **input, size_t *length)
 {
+    *input = (char*) RegionRealloc(*input, *length + 1, 2 * (*length) + 1);
     *length = 2 * (*length);
-    *input = (char*) realloc(*input, *length + 1);
-    assert(*input != NULL);
 }
 
 char *ReadLine(char in)
@@ -333,8 +315,7 @@ char *ReadLine(char in)
     unsigned int i = 0;
     size_t length = START;
 
-    tmp = (char*) malloc(sizeof(char) * (length + 1));
-    assert(tmp != NULL);
+    tmp = (char*) RegionAlloc(sizeof(char) * (length + 1));
     tmp[i++] = in;
     c = getchar();
     while (c != NEW_LINE && c != EOF) {
@@ -348,15 +329,23 @@ char *ReadLine(char in)
     return tmp;
 }
 
-int main(void)
+void *CalcRun(void *arg)
 {
     int line = 1;
     char *input = NULL;
     char in;
+    const char *tuning = getenv(POLY_TUNING_ENV);
     PolyStack *ps;
     Poly poly_result;
 
+    PolyMulLoadTuning(tuning != NULL ? tuning : POLY_TUNING_FILE);
     PolyStackInit(&ps);
+#ifdef POLY_INTERN
+    PolyInternEnable(true);
+#endif
+#ifdef POLY_RECLAIM
+    PolyReclaimStart(RECLAIM_QUEUE);
+#endif
     in = getchar();
     while (in != EOF) {
         if ((in >= 'a' && in <= 'z') || (in >= 'A' && in <= 'Z')) {
@@ -385,25 +374,57 @@ int main(void)
                 Print(line, ps);
             } else if (strcmp(input, POP) == 0) {
                 Pop(line, &ps);
+            } else if (strcmp(input, MEM) == 0) {
+                Mem(line, ps);
             } else if (memcmp(input, DEG_BY, 6) == 0) {
                 DegBy(input, line, ps);
             } else if (memcmp(input, AT, 2) == 0) {
                 At(input, line, &ps);
             } else if (memcmp(input, COMPOSE, 7) == 0) {
                 Compose(input, line, &ps);
+            } else if (memcmp(input, EVAL, 4) == 0) {
+                Eval(input, line, ps);
             } else {
                 ErrorWrongCommand(line);
             }
-            free(input);
         }
         else {
             if (ParsePoly(&poly_result, line, in)) {
                 PolyStackPush(&ps, poly_result);
             }
         }
+        RegionReset();
         line++;
         in = getchar();
     }
     PolyStackDelete(&ps);
+    EvalCacheClear();
+    PolyInternEnable(false);
+    PolyInternClear();
+    PolyReclaimStop();
+    RegionReleaseAll();
+    MemPoolReleaseAll();
+    return arg;
+}
+
+int main(void)
+{
+#ifndef UNIT_TESTING
+    /* W testach jednostkowych atrapa exit wraca longjmp do wątku, który
+     * wywołał main, więc polecenia wykonywane są bez osobnego wątku. */
+    pthread_attr_t attr;
+    pthread_t worker;
+
+    if (pthread_attr_init(&attr) == 0) {
+        if (pthread_attr_setstacksize(&attr, CALC_STACK_SIZE) == 0 &&
+            pthread_create(&worker, &attr, CalcRun, NULL) == 0) {
+            pthread_attr_destroy(&attr);
+            pthread_join(worker, NULL);
+            return 0;
+        }
+        pthread_attr_destroy(&attr);
+    }
+#endif
+    CalcRun(NULL);
     return 0;
 }
\ No newline at end of file
@@ -10,8 +10,18 @@
 #define WIELOMIANY_CALC_POLY_H
 
 #include "poly.h"
+#include "region.h"
 
 #define START 1 /**< początkowa wartość dynamicznych tablic */
+#define RECLAIM_QUEUE 1024 /**< pojemność kolejki zwalniania w tle */
+#define CALC_STACK_SIZE ((size_t) 1 << 30) /**< rozmiar stosu wątku
+                                              * wykonującego polecenia */
+#define POLY_TUNING_ENV "POLY_TUNING" /**< zmienna środowiskowa ze ścieżką
+                                        * pliku progów mnożenia */
+#ifndef POLY_TUNING_FILE
+#define POLY_TUNING_FILE "poly_tuning.cfg" /**< domyślny plik progów
+                                             * mnożenia, zob. autotune */
+#endif
 #define END '\0' /**< znak '\0' kończący napis */
 #define LMAX_LENGTH 19 /**< długość long_max */
 #define LMIN_LENGTH 20 /**< długość long_min */
@@ -30,9 +40,11 @@
 #define DEG "DEG" /**< napis DEG */
 #define PRINT "PRINT" /**< napis PRINT */
 #define POP "POP" /**< napis POP */
+#define MEM "MEM" /**< napis MEM */
 #define AT "AT" /**< napis AT */
 #define DEG_BY "DEG_BY" /**< napis DEG_BY */
 #define COMPOSE "COMPOSE" /**< napis COMPOSE */
+#define EVAL "EVAL" /**< napis EVAL */
 
 /**
  * Struktura stosowa przechowująca wielomiany
@@ -169,8 +181,19 @@ char *ReadLine(char in);
 char *ExtractNumber(int *index, size_t *new_length, char *c);
 
 /**
- * Funkcja wykonawcza kalkulatora.
+ * Pętla poleceń kalkulatora.
  * Pobiera napisy z zewnątrz, przetwarza je i wykonuje operacje na stosie
+ * @param[in] arg : nieużywany, zwracany bez zmian
+ * @return @p arg
+ */
+void *CalcRun(void *arg);
+
+/**
+ * Funkcja wykonawcza kalkulatora.
+ * Uruchamia CalcRun w wątku o stosie rozmiaru CALC_STACK_SIZE, bo
+ * działania na wielomianach są rekurencyjne względem głębokości
+ * zagnieżdżenia. Gdy wątku nie da się utworzyć, wykonuje CalcRun
+ * bezpośrednio.
  * @return 0
  */
 int main(void);
@@ -259,14 +282,14 @@ static inline void DigitStackInit(DigitStack **s)
 }
 
 /**
- * Umieszcza znak na stosie
+ * Umieszcza znak na stosie, węzeł przydzielany jest z regionu
+ * bieżącego polecenia
  * @param[in] s : stos znaków
  * @param[in] c : znak umieszczany
  */
 static inline void DigitStackPush(DigitStack **s, char c)
 {
-    DigitStack *pusher = (DigitStack*) malloc(sizeof(DigitStack));
-    assert(pusher != NULL);
+    DigitStack *pusher = (DigitStack*) RegionAlloc(sizeof(DigitStack));
 
     pusher->c = c;
     pusher->next = *s;
@@ -290,13 +313,10 @@ static inline bool DigitStackIsEmpty(const DigitStack *s)
  */
 static inline char DigitStackPop(DigitStack **s)
 {
-    DigitStack *deleter;
     char c;
 
     c = (*s)->c;
-    deleter = *s;
     *s = (*s)->next;
-    free(deleter);
 
     return c;
 }
@@ -332,14 +352,14 @@ static inline void MonoStackInit(MonoStack **s)
 }
 
 /**
- * Umieszcza monomian na stosie
+ * Umieszcza monomian na stosie, węzeł przydzielany jest z regionu
+ * bieżącego polecenia
  * @param[in] s : stos monomianów
  * @param[in] m : umieszczona wartość
  */
 static inline void MonoStackPush(MonoStack **s, Mono m)
 {
-    MonoStack *pusher = (MonoStack*) malloc(sizeof(MonoStack));
-    assert(pusher != NULL);
+    MonoStack *pusher = (MonoStack*) RegionAlloc(sizeof(MonoStack));
 
     pusher->m = m;
     pusher->next = *s;
@@ -363,13 +383,10 @@ static inline bool MonoStackIsEmpty(const MonoStack *s)
  */
 static inline Mono MonoStackPop(MonoStack **s)
 {
-    MonoStack *deleter;
     Mono m;
 
     m = (*s)->m;
-    deleter = *s;
     *s = (*s)->next;
-    free(deleter);
 
     return m;
 }
@@ -428,6 +445,16 @@ static inline void ErrorCorruptedAt(int line)
     fprintf(stderr, "ERROR %d WRONG VALUE\n", line);
 }
 
+/**
+ * Wypisuje na wyjście diagnostyczne informację o błędnej wartości w EVAL
+ * i numer aktualnego wiersza
+ * @param[in] line : numer aktualnego wiersza
+ */
+static inline void ErrorCorruptedEval(int line)
+{
+    fprintf(stderr, "ERROR %d WRONG VALUE\n", line);
+}
+
 /**
  * Wypisuje na wyjście diagnostyczne informację o błędnej wartości w DEG_BY
  * i numer aktualnego wiersza
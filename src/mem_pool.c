@@ -0,0 +1,262 @@
+/** @file
+   Pula pamięci dla małych obiektów o stałych rozmiarach
+
+   @author Piotr Szuberski <p.szuberski@student.uw.edu.pl>,
+   @copyright Uniwersytet Warszawski
+   @date 2026-10-18,
+*/
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+#include "utils.h"
+#include "mem_pool.h"
+
+/**
+ * Nagłówek slabu, slaby jednej klasy tworzą listę
+ */
+typedef struct PoolSlab {
+    struct PoolSlab *next; /**< next : następny slab tej samej klasy,
+                             * obiekty zaczynają się zaraz za nim */
+} PoolSlab;
+
+/**
+ * Wolny obiekt, wolne obiekty jednej klasy tworzą listę
+ */
+typedef struct PoolFreeNode {
+    struct PoolFreeNode *next; /**< next : następny wolny obiekt */
+} PoolFreeNode;
+
+/**
+ * Stan jednej klasy rozmiarów
+ */
+typedef struct PoolClass {
+    PoolFreeNode *free_list; /**< free_list : lista zwolnionych obiektów */
+    /** remote_free : lista obiektów zwolnionych przez inne wątki */
+    PoolFreeNode *remote_free;
+    char *cursor; /**< cursor : pierwszy nieużyty bajt bieżącego slabu */
+    char *end; /**< end : koniec bieżącego slabu */
+    PoolSlab *slabs; /**< slabs : lista wszystkich slabów klasy */
+} PoolClass;
+
+/** Klasy rozmiarów puli */
+static PoolClass pool_classes[POOL_CLASSES];
+
+/**
+ * Liczniki przydziałów; pamięć oddaną przez inne wątki liczy osobny,
+ * atomowy licznik remote_freed
+ */
+static struct {
+    size_t allocated; /**< allocated : pamięć przydzielona */
+    size_t freed; /**< freed : pamięć oddana przez MemPoolFree */
+    size_t remote_freed; /**< remote_freed : pamięć oddana z innych wątków */
+    size_t peak; /**< peak : największa ilość pamięci w użyciu */
+    size_t allocs; /**< allocs : liczba przydziałów */
+} pool_stats;
+
+/**
+ * Wyznacza numer klasy dla obiektu o zadanym rozmiarze
+ * @param[in] size : rozmiar obiektu
+ * @return numer klasy lub POOL_CLASSES, gdy obiekt jest za duży
+ */
+static inline size_t PoolClassOf(size_t size)
+{
+    return size == 0 ? 0 : (size - 1) / POOL_GRANULE;
+}
+
+size_t MemPoolBlockSize(size_t size)
+{
+    size_t c = PoolClassOf(size);
+
+    return c < POOL_CLASSES ? (c + 1) * POOL_GRANULE : size;
+}
+
+/**
+ * Zwraca ilość pamięci w użyciu
+ * @return pamięć przydzielona pomniejszona o oddaną
+ */
+static inline size_t PoolLiveBytes(void)
+{
+    return pool_stats.allocated - pool_stats.freed -
+           __atomic_load_n(&pool_stats.remote_freed, __ATOMIC_RELAXED);
+}
+
+/**
+ * Odnotowuje przydział obiektu w licznikach
+ * @param[in] size : rozmiar obiektu
+ */
+static inline void PoolCountAlloc(size_t size)
+{
+    size_t live;
+
+    pool_stats.allocs++;
+    pool_stats.allocated += MemPoolBlockSize(size);
+    live = PoolLiveBytes();
+    if (live > pool_stats.peak) {
+        pool_stats.peak = live;
+    }
+}
+
+/**
+ * Odnotowuje oddanie obiektu w licznikach
+ * @param[in] size : rozmiar obiektu
+ * @param[in] remote : czy obiekt oddaje inny wątek
+ */
+static inline void PoolCountFree(size_t size, bool remote)
+{
+    if (remote) {
+        __atomic_fetch_add(&pool_stats.remote_freed, MemPoolBlockSize(size),
+                           __ATOMIC_RELAXED);
+    }
+    else {
+        pool_stats.freed += MemPoolBlockSize(size);
+    }
+}
+
+#ifndef UNIT_TESTING
+
+/**
+ * Dokłada do klasy nowy slab
+ * @param[in] pc : klasa rozmiarów
+ */
+static void PoolGrow(PoolClass *pc)
+{
+    PoolSlab *slab = (PoolSlab*) malloc(POOL_SLAB_SIZE);
+    assert(slab != NULL);
+
+    slab->next = pc->slabs;
+    pc->slabs = slab;
+    pc->cursor = (char*) (slab + 1);
+    pc->end = (char*) slab + POOL_SLAB_SIZE;
+}
+
+void *MemPoolAlloc(size_t size)
+{
+    size_t c = PoolClassOf(size);
+    size_t block = (c + 1) * POOL_GRANULE;
+    PoolClass *pc;
+    void *ptr;
+
+    PoolCountAlloc(size);
+    if (c >= POOL_CLASSES) {
+        ptr = malloc(size);
+        assert(ptr != NULL);
+        return ptr;
+    }
+    pc = &pool_classes[c];
+    if (pc->free_list == NULL &&
+        __atomic_load_n(&pc->remote_free, __ATOMIC_RELAXED) != NULL) {
+        pc->free_list = __atomic_exchange_n(&pc->remote_free, NULL,
+                                            __ATOMIC_ACQUIRE);
+    }
+    if (pc->free_list != NULL) {
+        ptr = pc->free_list;
+        pc->free_list = pc->free_list->next;
+        return ptr;
+    }
+    if (pc->cursor == NULL || (size_t) (pc->end - pc->cursor) < block) {
+        PoolGrow(pc);
+    }
+    ptr = pc->cursor;
+    pc->cursor += block;
+    return ptr;
+}
+
+void MemPoolFree(void *ptr, size_t size)
+{
+    size_t c = PoolClassOf(size);
+    PoolFreeNode *node = (PoolFreeNode*) ptr;
+
+    if (ptr == NULL) {
+        return;
+    }
+    PoolCountFree(size, false);
+    if (c >= POOL_CLASSES) {
+        free(ptr);
+        return;
+    }
+    node->next = pool_classes[c].free_list;
+    pool_classes[c].free_list = node;
+}
+
+void MemPoolFreeRemote(void *ptr, size_t size)
+{
+    size_t c = PoolClassOf(size);
+    PoolFreeNode *node = (PoolFreeNode*) ptr;
+    PoolClass *pc;
+
+    if (ptr == NULL) {
+        return;
+    }
+    PoolCountFree(size, true);
+    if (c >= POOL_CLASSES) {
+        free(ptr);
+        return;
+    }
+    pc = &pool_classes[c];
+    node->next = __atomic_load_n(&pc->remote_free, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&pc->remote_free, &node->next, node,
+                                        true, __ATOMIC_RELEASE,
+                                        __ATOMIC_RELAXED)) {
+    }
+}
+
+#else /* UNIT_TESTING */
+
+/*
+ * W testach jednostkowych każdy obiekt przydzielany jest osobno, żeby
+ * cmocka mogła wykrywać wycieki pamięci w pojedynczym teście.
+ */
+
+void *MemPoolAlloc(size_t size)
+{
+    void *ptr = malloc(size);
+    assert(ptr != NULL);
+    PoolCountAlloc(size);
+    return ptr;
+}
+
+void MemPoolFree(void *ptr, size_t size)
+{
+    if (ptr != NULL) {
+        PoolCountFree(size, false);
+    }
+    free(ptr);
+}
+
+void MemPoolFreeRemote(void *ptr, size_t size)
+{
+    if (ptr != NULL) {
+        PoolCountFree(size, true);
+    }
+    free(ptr);
+}
+
+#endif /* UNIT_TESTING */
+
+MemPoolStats MemPoolGetStats(void)
+{
+    MemPoolStats stats;
+
+    stats.live_bytes = PoolLiveBytes();
+    stats.peak_bytes = pool_stats.peak;
+    stats.allocs = pool_stats.allocs;
+    return stats;
+}
+
+void MemPoolReleaseAll(void)
+{
+    PoolSlab *slab;
+
+    for (size_t c = 0; c < POOL_CLASSES; c++) {
+        while (pool_classes[c].slabs != NULL) {
+            slab = pool_classes[c].slabs;
+            pool_classes[c].slabs = slab->next;
+            free(slab);
+        }
+        pool_classes[c].free_list = NULL;
+        pool_classes[c].remote_free = NULL;
+        pool_classes[c].cursor = NULL;
+        pool_classes[c].end = NULL;
+    }
+}
@@ -0,0 +1,83 @@
+/** @file
+   Interfejs puli pamięci dla małych obiektów o stałych rozmiarach
+
+   Pamięć przydzielana jest z dużych bloków (slabów) podzielonych na klasy
+   rozmiarów. Zwolnione obiekty trafiają na listę wolnych obiektów swojej
+   klasy i są używane ponownie przy kolejnym przydziale. Wszystkie slaby
+   można zwolnić jednocześnie funkcją MemPoolReleaseAll.
+   Pula należy do jednego wątku; inne wątki mogą jedynie oddawać do niej
+   obiekty funkcją MemPoolFreeRemote.
+
+   @author Piotr Szuberski <p.szuberski@student.uw.edu.pl>,
+   @copyright Uniwersytet Warszawski
+   @date 2026-10-18,
+*/
+
+#ifndef WIELOMIANY_MEM_POOL_H
+#define WIELOMIANY_MEM_POOL_H
+
+#include <stddef.h>
+
+/** Ziarnistość klas rozmiarów w bajtach; równa wyrównaniu wskaźnika, żeby
+ * 24-bajtowy jednomian zajmował blok 24, a nie 32 bajtów */
+#define POOL_GRANULE 8
+
+/** Liczba klas rozmiarów, większe obiekty przydzielane są przez malloc */
+#define POOL_CLASSES 32
+
+/** Rozmiar pojedynczego slabu w bajtach */
+#define POOL_SLAB_SIZE (64 * 1024)
+
+/**
+ * Liczniki przydziałów puli od początku działania programu
+ */
+typedef struct MemPoolStats {
+    size_t live_bytes; /**< live_bytes : pamięć obiektów w użyciu */
+    size_t peak_bytes; /**< peak_bytes : największa wartość live_bytes */
+    size_t allocs; /**< allocs : liczba wywołań MemPoolAlloc */
+} MemPoolStats;
+
+/**
+ * Przydziela obiekt o rozmiarze @p size z puli odpowiedniej klasy.
+ * @param[in] size : rozmiar obiektu w bajtach
+ * @return wskaźnik na przydzieloną pamięć
+ */
+void *MemPoolAlloc(size_t size);
+
+/**
+ * Oddaje obiekt do puli. Rozmiar musi być taki sam jak przy przydziale.
+ * @param[in] ptr : zwalniany obiekt
+ * @param[in] size : rozmiar obiektu w bajtach
+ */
+void MemPoolFree(void *ptr, size_t size);
+
+/**
+ * Oddaje obiekt do puli z innego wątku niż ten, który z niej przydziela.
+ * Obiekt trafia na osobną listę klasy, przejmowaną przez MemPoolAlloc,
+ * gdy lista wolnych obiektów się wyczerpie.
+ * @param[in] ptr : zwalniany obiekt
+ * @param[in] size : rozmiar obiektu w bajtach
+ */
+void MemPoolFreeRemote(void *ptr, size_t size);
+
+/**
+ * Wyznacza, ile pamięci puli zajmuje obiekt o zadanym rozmiarze.
+ * @param[in] size : rozmiar obiektu w bajtach
+ * @return rozmiar bloku klasy lub @p size, gdy obiekt jest za duży
+ */
+size_t MemPoolBlockSize(size_t size);
+
+/**
+ * Zwraca liczniki przydziałów. Rozmiar obiektu z puli liczony jest
+ * z zaokrągleniem do rozmiaru klasy.
+ * @return liczniki przydziałów puli
+ */
+MemPoolStats MemPoolGetStats(void);
+
+/**
+ * Zwalnia wszystkie slaby wszystkich klas. Wolno ją wywołać tylko wtedy,
+ * gdy żaden obiekt przydzielony z puli nie jest już używany.
+ */
+void MemPoolReleaseAll(void);
+
+#endif //WIELOMIANY_MEM_POOL_H
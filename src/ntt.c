@@ -0,0 +1,355 @@
+/** @file
+   Mnożenie wielomianów szybką transformatą teorioliczbową
+
+   @author Piotr Szuberski <p.szuberski@student.uw.edu.pl>,
+   @copyright Uniwersytet Warszawski
+   @date 2026-10-18,
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "utils.h"
+#include "region.h"
+#include "ntt.h"
+
+/** Liczba 128-bitowa dla iloczynów reszt */
+typedef unsigned __int128 NttWide;
+
+/**
+ * Liczba pierwsza p = c * 2^32 + 1 z pierwiastkiem pierwotnym
+ */
+typedef struct NttPrime {
+    uint64_t p; /**< p : liczba pierwsza z przedziału (2^61, 2^62) */
+    uint64_t g; /**< g : pierwiastek pierwotny modulo p */
+} NttPrime;
+
+/** Liczby pierwsze kolejnych transformat */
+static const NttPrime ntt_primes[NTT_PRIMES] = {
+    {4611685941117976577UL, 3},
+    {4611685692009873409UL, 19},
+    {4611685606110527489UL, 3}
+};
+
+/**
+ * Stałe arytmetyki Montgomery'ego modulo p dla R = 2^64
+ */
+typedef struct NttField {
+    uint64_t p; /**< p : moduł */
+    uint64_t neg_inv; /**< neg_inv : -p^(-1) modulo 2^64 */
+    uint64_t r; /**< r : 2^64 modulo p */
+    uint64_t r2; /**< r2 : 2^128 modulo p */
+} NttField;
+
+/**
+ * Mnoży reszty modulo p dzieleniem 128-bitowym, do obliczania stałych
+ * @param[in] a : reszta
+ * @param[in] b : reszta
+ * @param[in] p : moduł
+ * @return `a * b mod p`
+ */
+static uint64_t NttMulSlow(uint64_t a, uint64_t b, uint64_t p)
+{
+    return (uint64_t) ((NttWide) a * b % p);
+}
+
+/**
+ * Potęguje resztę modulo p
+ * @param[in] a : podstawa
+ * @param[in] e : wykładnik
+ * @param[in] p : moduł
+ * @return `a^e mod p`
+ */
+static uint64_t NttPowSlow(uint64_t a, uint64_t e, uint64_t p)
+{
+    uint64_t result = 1;
+
+    while (e > 0) {
+        if (e & 1) {
+            result = NttMulSlow(result, a, p);
+        }
+        a = NttMulSlow(a, a, p);
+        e >>= 1;
+    }
+    return result;
+}
+
+/**
+ * Wylicza stałe arytmetyki Montgomery'ego
+ * @param[out] f : wypełniane stałe
+ * @param[in] p : nieparzysty moduł mniejszy od 2^62
+ */
+static void NttFieldInit(NttField *f, uint64_t p)
+{
+    uint64_t inv = p;
+
+    for (int i = 0; i < 5; i++) {
+        inv *= 2 - p * inv;
+    }
+    f->p = p;
+    f->neg_inv = -inv;
+    f->r = (uint64_t) (((NttWide) 1 << 64) % p);
+    f->r2 = NttMulSlow(f->r, f->r, p);
+}
+
+/**
+ * Iloczyn Montgomery'ego
+ * @param[in] f : stałe modułu
+ * @param[in] a : reszta
+ * @param[in] b : reszta
+ * @return `a * b * 2^(-64) mod p`
+ */
+static inline uint64_t NttMont(const NttField *f, uint64_t a, uint64_t b)
+{
+    NttWide t = (NttWide) a * b;
+    uint64_t m = (uint64_t) t * f->neg_inv;
+    uint64_t u = (uint64_t) ((t + (NttWide) m * f->p) >> 64);
+
+    return u >= f->p ? u - f->p : u;
+}
+
+/**
+ * Zamienia resztę na postać Montgomery'ego
+ * @param[in] f : stałe modułu
+ * @param[in] a : reszta
+ * @return `a * 2^64 mod p`
+ */
+static inline uint64_t NttToMont(const NttField *f, uint64_t a)
+{
+    return NttMont(f, a, f->r2);
+}
+
+/**
+ * Wyznacza resztę modulo p liczby ze znakiem zapisanej w kodzie
+ * uzupełnień do dwóch
+ * @param[in] f : stałe modułu
+ * @param[in] x : liczba
+ * @return `x mod p`
+ */
+static inline uint64_t NttReduce(const NttField *f, unsigned long x)
+{
+    uint64_t r = x % f->p;
+
+    if ((long) x >= 0) {
+        return r;
+    }
+    return r >= f->r ? r - f->r : r + f->p - f->r;
+}
+
+/**
+ * Wylicza w postaci Montgomery'ego pierwiastki z jedności dla wszystkich
+ * etapów transformaty; pierwiastki etapu o połowie długości half leżą
+ * w roots[half .. 2 * half - 1]
+ * @param[in] f : stałe modułu
+ * @param[in] g : pierwiastek pierwotny modulo p
+ * @param[in] len : długość transformaty, potęga dwójki
+ * @param[out] roots : tablica długości @p len
+ */
+static void NttRoots(const NttField *f, uint64_t g, size_t len,
+                     uint64_t roots[])
+{
+    uint64_t step, cur;
+
+    for (size_t half = 1; half < len; half *= 2) {
+        step = NttToMont(f, NttPowSlow(g, (f->p - 1) / (2 * half), f->p));
+        cur = f->r;
+        for (size_t j = 0; j < half; j++) {
+            roots[half + j] = cur;
+            cur = NttMont(f, cur, step);
+        }
+    }
+}
+
+/**
+ * Transformata teorioliczbowa w miejscu
+ * @param[in] f : stałe modułu
+ * @param[in,out] a : reszty, tablica długości @p len
+ * @param[in] len : długość transformaty, potęga dwójki
+ * @param[in] roots : pierwiastki z NttRoots
+ */
+static void NttTransform(const NttField *f, uint64_t a[], size_t len,
+                         const uint64_t roots[])
+{
+    uint64_t u, v, swap;
+    size_t bit, j = 0;
+
+    for (size_t i = 1; i < len; i++) {
+        for (bit = len >> 1; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            swap = a[i];
+            a[i] = a[j];
+            a[j] = swap;
+        }
+    }
+    for (size_t half = 1; half < len; half *= 2) {
+        for (size_t i = 0; i < len; i += 2 * half) {
+            for (size_t k = 0; k < half; k++) {
+                u = a[i + k];
+                v = NttMont(f, a[i + k + half], roots[half + k]);
+                a[i + k] = u + v >= f->p ? u + v - f->p : u + v;
+                a[i + k + half] = u >= v ? u - v : u + f->p - v;
+            }
+        }
+    }
+}
+
+/**
+ * Liczy iloczyn modulo jedna liczba pierwsza; kwadrat, czyli ten sam
+ * czynnik podany dwa razy, wymaga tylko jednej transformaty w przód
+ * @param[in] prime : liczba pierwsza i jej pierwiastek pierwotny
+ * @param[in] a : współczynniki pierwszego czynnika
+ * @param[in] n : długość @p a
+ * @param[in] b : współczynniki drugiego czynnika
+ * @param[in] m : długość @p b
+ * @param[in] len : długość transformaty
+ * @param[out] out : reszty współczynników iloczynu, tablica długości @p len
+ */
+static void NttMulPrime(const NttPrime *prime, const unsigned long a[],
+                        size_t n, const unsigned long b[], size_t m,
+                        size_t len, uint64_t out[])
+{
+    RegionMark mark = RegionSave();
+    bool square = a == b && n == m;
+    uint64_t *other = square ? out :
+                      (uint64_t*) RegionAlloc(sizeof(uint64_t) * len);
+    uint64_t *roots = (uint64_t*) RegionAlloc(sizeof(uint64_t) * len);
+    uint64_t scale, swap;
+    NttField f;
+
+    NttFieldInit(&f, prime->p);
+    for (size_t i = 0; i < len; i++) {
+        out[i] = i < n ? NttReduce(&f, a[i]) : 0;
+        if (!square) {
+            other[i] = i < m ? NttReduce(&f, b[i]) : 0;
+        }
+    }
+    NttRoots(&f, prime->g, len, roots);
+    NttTransform(&f, out, len, roots);
+    if (!square) {
+        NttTransform(&f, other, len, roots);
+    }
+    for (size_t i = 0; i < len; i++) {
+        out[i] = NttMont(&f, NttMont(&f, out[i], other[i]), f.r2);
+    }
+    /* transformata odwrotna: ta sama transformata z odwróconymi indeksami */
+    NttTransform(&f, out, len, roots);
+    for (size_t i = 1, j = len - 1; i < j; i++, j--) {
+        swap = out[i];
+        out[i] = out[j];
+        out[j] = swap;
+    }
+    scale = NttToMont(&f, NttPowSlow(len % f.p, f.p - 2, f.p));
+    for (size_t i = 0; i < len; i++) {
+        out[i] = NttMont(&f, out[i], scale);
+    }
+    RegionRestore(mark);
+}
+
+/**
+ * Liczy długość zapisu binarnego liczby
+ * @param[in] x : liczba
+ * @return liczba bitów
+ */
+static inline unsigned NttBits(uint64_t x)
+{
+    return x == 0 ? 0 : 64 - (unsigned) __builtin_clzll(x);
+}
+
+/**
+ * Wyznacza największą wartość bezwzględną współczynnika
+ * @param[in] a : współczynniki
+ * @param[in] n : długość @p a
+ * @return największa wartość bezwzględna
+ */
+static uint64_t NttMaxAbs(const unsigned long a[], size_t n)
+{
+    uint64_t max = 0, abs;
+
+    for (size_t i = 0; i < n; i++) {
+        abs = (long) a[i] < 0 ? -(uint64_t) a[i] : a[i];
+        if (abs > max) {
+            max = abs;
+        }
+    }
+    return max;
+}
+
+unsigned NttPrimesNeeded(const unsigned long a[], size_t n,
+                         const unsigned long b[], size_t m)
+{
+    uint64_t max_a = NttMaxAbs(a, n), max_b = NttMaxAbs(b, m);
+    unsigned bits;
+
+    if (max_a == 0 || max_b == 0) {
+        return 0;
+    }
+    /* |współczynnik| < 2^(bits - 1), a iloczyn k liczb pierwszych > 2^61k */
+    bits = NttBits(max_a) + NttBits(max_b) + NttBits(n < m ? n : m) + 1;
+    return (bits + 60) / 61;
+}
+
+void NttMul(const unsigned long a[], size_t n,
+            const unsigned long b[], size_t m, unsigned long out[])
+{
+    RegionMark mark;
+    uint64_t *res[NTT_PRIMES];
+    uint64_t p1 = ntt_primes[0].p, p2 = ntt_primes[1].p, p3 = ntt_primes[2].p;
+    uint64_t inv12, inv13, inv23, x1, x2, x3, t, modulus = 1;
+    size_t len = 1, length = n + m - 1;
+    unsigned primes = NttPrimesNeeded(a, n, b, m);
+    NttField f2, f3;
+    bool negative;
+
+    if (primes == 0) {
+        memset(out, 0, sizeof(unsigned long) * length);
+        return;
+    }
+    while (len < length) {
+        len *= 2;
+    }
+    mark = RegionSave();
+    for (unsigned k = 0; k < primes; k++) {
+        res[k] = (uint64_t*) RegionAlloc(sizeof(uint64_t) * len);
+        NttMulPrime(&ntt_primes[k], a, n, b, m, len, res[k]);
+        modulus *= ntt_primes[k].p;
+    }
+    NttFieldInit(&f2, p2);
+    NttFieldInit(&f3, p3);
+    inv12 = NttToMont(&f2, NttPowSlow(p1 % p2, p2 - 2, p2));
+    inv13 = NttToMont(&f3, NttPowSlow(p1 % p3, p3 - 2, p3));
+    inv23 = NttToMont(&f3, NttPowSlow(p2 % p3, p3 - 2, p3));
+    for (size_t i = 0; i < length; i++) {
+        /* algorytm Garnera: x = x1 + x2 * p1 + x3 * p1 * p2 */
+        x1 = res[0][i];
+        x2 = 0;
+        x3 = 0;
+        if (primes > 1) {
+            t = x1 >= p2 ? x1 - p2 : x1;
+            t = res[1][i] >= t ? res[1][i] - t : res[1][i] + p2 - t;
+            x2 = NttMont(&f2, t, inv12);
+        }
+        if (primes > 2) {
+            t = x1 >= p3 ? x1 - p3 : x1;
+            t = res[2][i] >= t ? res[2][i] - t : res[2][i] + p3 - t;
+            t = NttMont(&f3, t, inv13);
+            x3 = x2 >= p3 ? x2 - p3 : x2;
+            t = t >= x3 ? t - x3 : t + p3 - x3;
+            x3 = NttMont(&f3, t, inv23);
+        }
+        /* x > (P - 1) / 2 oznacza liczbę ujemną x - P */
+        if (primes > 2 && x3 != (p3 - 1) / 2) {
+            negative = x3 > (p3 - 1) / 2;
+        }
+        else if (primes > 1 && x2 != (p2 - 1) / 2) {
+            negative = x2 > (p2 - 1) / 2;
+        }
+        else {
+            negative = x1 > (p1 - 1) / 2;
+        }
+        out[i] = x1 + x2 * p1 + x3 * p1 * p2 - (negative ? modulus : 0);
+    }
+    RegionRestore(mark);
+}
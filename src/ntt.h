@@ -0,0 +1,50 @@
+/** @file
+   Interfejs mnożenia wielomianów szybką transformatą teorioliczbową
+
+   Iloczyn liczony jest modulo kilku 62-bitowych liczb pierwszych postaci
+   c * 2^32 + 1, a współczynniki odtwarzane są z chińskiego twierdzenia
+   o resztach. Liczba użytych liczb pierwszych zależy od oszacowania
+   wielkości współczynników wyniku: gdy może on przekroczyć zakres
+   poly_coeff_t, odtwarzana jest pełna wartość i redukowana modulo 2^64,
+   tak jak przy mnożeniu szkolnym.
+
+   @author Piotr Szuberski <p.szuberski@student.uw.edu.pl>,
+   @copyright Uniwersytet Warszawski
+   @date 2026-10-18,
+*/
+
+#ifndef WIELOMIANY_NTT_H
+#define WIELOMIANY_NTT_H
+
+#include <stddef.h>
+
+/** Największa liczba liczb pierwszych używanych do odtworzenia wyniku */
+#define NTT_PRIMES 3
+
+/**
+ * Wyznacza, ilu liczb pierwszych wymaga NttMul, żeby odtworzyć dokładne
+ * współczynniki iloczynu.
+ * @param[in] a : współczynniki pierwszego czynnika
+ * @param[in] n : długość @p a
+ * @param[in] b : współczynniki drugiego czynnika
+ * @param[in] m : długość @p b
+ * @return liczba od 0 (iloczyn zerowy) do NTT_PRIMES
+ */
+unsigned NttPrimesNeeded(const unsigned long a[], size_t n,
+                         const unsigned long b[], size_t m);
+
+/**
+ * Mnoży wielomiany jednej zmiennej o współczynnikach traktowanych jako
+ * liczby ze znakiem w kodzie uzupełnień do dwóch. Wynik jest identyczny
+ * z mnożeniem szkolnym modulo 2^64. Gdy @p b to ta sama tablica co @p a,
+ * liczony jest kwadrat z jedną transformatą w przód zamiast dwóch.
+ * @param[in] a : współczynniki pierwszego czynnika
+ * @param[in] n : długość @p a, dodatnia
+ * @param[in] b : współczynniki drugiego czynnika
+ * @param[in] m : długość @p b, dodatnia
+ * @param[out] out : współczynniki iloczynu, tablica długości `n + m - 1`
+ */
+void NttMul(const unsigned long a[], size_t n,
+            const unsigned long b[], size_t m, unsigned long out[]);
+
+#endif //WIELOMIANY_NTT_H
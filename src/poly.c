@@ -7,8 +7,18 @@
 */
 
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
 #include "utils.h"
+#include "mem_pool.h"
+#include "region.h"
+#include "batch_eval.h"
 #include "poly.h"
+#include "poly_internal.h"
+
+static_assert(sizeof(Mono) <= 24, "Mono powinien zajmować najwyżej 24 bajty");
+static_assert(_Alignof(Mono) > MONO_TAG_MASK,
+              "wyrównanie Mono musi zostawiać wolne bity na typ współczynnika");
 
 /**
  * Pomocnicza funkcja dla PolyAddMonos do quicksorta z biblioteki,
@@ -21,21 +31,30 @@ static poly_exp_t MonoExpComparator(const void *x1, const void *x2);
 
 /**
  * Uzupełnia listę monomianów o "ogon" pozostałej listy monomianów,
- * pomocnicza funkcja funkcji PolyMul.
+ * pomocnicza funkcja funkcji PolyAdd i PolySub.
  * @param[in] toComplete: lista monomianów, która będzie uzupełniona
  * o monomiany z klonowanej listy
  * @param[in] cloned: klonowana lista
+ * @param[in] map : funkcja tworząca współczynniki nowych monomianów
+ * (PolyClone albo PolyNeg)
  */
-static void MonoComplete(Mono **toComplete, Mono *cloned);
+static void MonoComplete(Mono **toComplete, Mono *cloned,
+                         Poly (*map)(const Poly *));
 
 /**
  * Tworzy zaalokowany monomian posiadający zerowy współczynnik
- * dla zainicjalizowania pola p, później musi zostać nadpisany.
+ * dla zainicjalizowania współczynnika, później musi zostać nadpisany.
  * @param[in] x: wykładnik monomianu
  * @return zaalokowany monomian
  */
 static Mono *MonoEmpty(poly_exp_t x);
 
+/**
+ * Oddaje do puli pamięć jednomianu, nie usuwając jego współczynnika.
+ * @param[in] m : jednomian
+ */
+static inline void MonoFree(Mono *m);
+
 /**
  * Na podstawie konstrukcji listy monomianów wybiera,
  * jaki wielomian utworzyć, pomocnicza funkcja dla PolyAdd
@@ -46,26 +65,63 @@ static Mono *MonoEmpty(poly_exp_t x);
 static Poly PolyChoose(Mono *m);
 
 /**
- * Pomocnicza funkcja dla PolyMul, liczy liczbę bloków
- * potrzebnych do zaalokowania w pamięci
- * @param[in] m: lista monomianów
- * @return liczba monomianów w liście
+ * Oddaje do puli tablicę jednomianów, nie usuwając ich współczynników.
+ * @param[in] arr : pierwszy element tablicy
+ * @param[in] count : liczba jednomianów
  */
-static poly_exp_t MonoCountBlocks(const Mono *m);
+static inline void MonoArrayFree(Mono *arr, unsigned count);
 
 /**
- * Usuwa dynamicznie zaalokowany jednomian z pamięci.
- * @param[in] m: jednomian
+ * Zamienia reprezentację tablicową poziomu wielomianu na listę, przenosząc
+ * współczynniki do nowych węzłów. Inne reprezentacje zostają bez zmian.
+ * @param[in,out] p : wielomian
  */
-static void PolyDestroyMono(Mono *m);
+static void PolyUnpack(Poly *p);
+
+/**
+ * Tworzy wielomian w reprezentacji tablicowej o tych samych wykładnikach
+ * co @p p, ze współczynnikami przekształconymi funkcją @p map,
+ * pomocnicza funkcja dla PolyNeg i PolyUnshare.
+ * @param[in] p : wielomian w reprezentacji tablicowej
+ * @param[in] map : funkcja tworząca nowy współczynnik
+ * @return przekształcony wielomian
+ */
+static Poly PolyArrayMap(const Poly *p, Poly (*map)(const Poly *));
+
+/**
+ * Tworzy wielomian w reprezentacji listowej o tych samych wykładnikach
+ * co @p p, ze współczynnikami przekształconymi funkcją @p map,
+ * pomocnicza funkcja dla PolyNeg i PolyUnshare.
+ * @param[in] p : wielomian w reprezentacji listowej
+ * @param[in] map : funkcja tworząca nowy współczynnik
+ * @return przekształcony wielomian
+ */
+static Poly PolyListMap(const Poly *p, Poly (*map)(const Poly *));
+
+/** Liczniki wartościowania w wielu punktach, zob. PolyEvalGetStats */
+static PolyEvalStats eval_stats = {0, 0};
+
+/**
+ * Liczy jednomiany najwyższego poziomu wielomianu, miarę wielkości
+ * dla akumulatora PolyBucket.
+ * @param[in] p : wielomian
+ * @return liczba jednomianów
+ */
+static size_t PolyTermCount(const Poly *p);
+
+/**
+ * Wyznacza kubełek akumulatora, do którego trafia suma o danej liczbie
+ * jednomianów.
+ * @param[in] size : liczba jednomianów najwyższego poziomu
+ * @return numer kubełka
+ */
+static unsigned PolyBucketIndex(size_t size);
 
 /**
- * Funkcja wykonująca algorytm binpower
- * @param[in] x: podstawa potęgi
- * @param[in] n: wykładnik potęgi
- * @return 'x^n'
+ * Usuwa dynamicznie zaalokowany jednomian z pamięci.
+ * @param[in] m: jednomian
  */
-static poly_coeff_t PolyPower(poly_coeff_t x, poly_exp_t n);
+static void PolyDestroyMono(Mono *m);
 
 /**
  * Dołącza pozostałą część listy
@@ -75,18 +131,132 @@ static poly_coeff_t PolyPower(poly_coeff_t x, poly_exp_t n);
 static void MonoCompleteNoConsts(Mono *toComplete, Mono *cloned);
 
 /**
- * Funkcja pomocnicza funkcji wypisującej wielomian
+ * Funkcja pomocnicza funkcji wypisującej wielomian, przechodzi wielomian
+ * bez rekurencji, trzymając ścieżkę od korzenia na stosie roboczym
  * @param[in] p: wypisywany wielomian
  */
 static void PolyPrintMain(const Poly *p);
 
 /**
- * Funkcja dodająca wielomiany i usuwająca swoje argumenty,
- * @param[in] p
- * @param[in] q
- * @return 'p + q'
+ * Wypisuje wielomian, jeśli jest zerem, stałą lub liściem.
+ * @param[in] p : wypisywany wielomian
+ * @return czy wielomian został wypisany?
+ */
+static bool PolyPrintFlat(const Poly *p);
+
+/**
+ * Porównuje najwyższe poziomy dwóch wielomianów, pary współczynników
+ * do porównania odkładając na stos, pomocnicza funkcja dla PolyIsEq.
+ * @param[in] p : wielomian
+ * @param[in] q : wielomian
+ * @param[in,out] pending : stos par wielomianów (Poly[2])
+ * @return czy poziomy mogą być równe?
+ */
+static bool PolyLevelIsEq(const Poly *p, const Poly *q, WorkStack *pending);
+
+/** Początkowa pojemność zbioru odwiedzonych poziomów */
+#define LEVEL_SET_START 64
+
+/**
+ * Pozycja zbioru odwiedzonych poziomów
+ */
+typedef struct LevelSlot {
+    const void *level; /**< level : pierwszy jednomian lub liść poziomu,
+                         * NULL w pustej pozycji */
+    unsigned depth; /**< depth : największa głębokość, na jakiej poziom
+                      * został osiągnięty */
+} LevelSlot;
+
+/**
+ * Zbiór poziomów odwiedzonych przez PolyMemStatsMany, adresowany
+ * wskaźnikiem na poziom, żeby współdzielony poziom liczyć raz.
+ */
+typedef struct LevelSet {
+    LevelSlot *slots; /**< slots : tablica z adresowaniem otwartym */
+    size_t size; /**< size : liczba zajętych pozycji */
+    size_t capacity; /**< capacity : pojemność, potęga dwójki */
+} LevelSet;
+
+/**
+ * Odnotowuje osiągnięcie poziomu na zadanej głębokości.
+ * @param[in,out] set : zbiór odwiedzonych poziomów
+ * @param[in] level : pierwszy jednomian lub liść poziomu
+ * @param[in] depth : głębokość poziomu
+ * @return 1, gdy poziom jest nowy, 0, gdy osiągnięto go już wcześniej,
+ * ale płycej, -1, gdy nie trzeba go ponownie przechodzić
+ */
+static int LevelSetVisit(LevelSet *set, const void *level, unsigned depth);
+
+/** Górne ograniczenie liczby potęg zmiennej liczonych z góry przy
+ * wykonaniu planu wartościowania */
+#define PLAN_POWERS 64
+
+/**
+ * Rozkazy planu wartościowania, zob. PolyEvalPlan. Każdy poziom planu
+ * liczy schematem Hornera, od najwyższego wykładnika, wartość w zmiennej
+ * o indeksie równym głębokości poziomu.
+ */
+enum PlanOp {
+    PLAN_RUN, /**< liczba par, potem pary (różnica wykładników,
+               * współczynnik) kolejnych stałych współczynników */
+    PLAN_OPEN, /**< początek współczynnika niebędącego stałą */
+    PLAN_CLOSE, /**< koniec współczynnika, argument: różnica wykładników */
+    PLAN_SHIFT /**< mnoży wartość poziomu przez potęgę zmiennej,
+                * argument: najniższy wykładnik poziomu */
+};
+
+/**
+ * Dopisuje słowo na koniec programu.
+ * @param[in,out] code : program
+ * @param[in] word : słowo
+ */
+static void PlanEmit(WorkStack *code, poly_coeff_t word);
+
+/**
+ * Dopisuje różnicę wykładników na koniec programu i powiększa liczbę
+ * potęg liczonych z góry, jeśli różnica jest mniejsza od PLAN_POWERS.
+ * @param[in,out] code : program
+ * @param[in,out] plan : plan
+ * @param[in] gap : różnica wykładników
+ */
+static void PlanEmitGap(WorkStack *code, PolyEvalPlan *plan, poly_exp_t gap);
+
+/**
+ * Kompiluje poziom wielomianu do programu planu wartościowania.
+ * @param[in] p : wielomian normalny
+ * @param[in] level : głębokość poziomu
+ * @param[in,out] code : program
+ * @param[in,out] plan : plan, w którym uzupełniane są depth i powers
+ */
+static void PlanCompileLevel(const Poly *p, unsigned level, WorkStack *code,
+                             PolyEvalPlan *plan);
+
+/**
+ * Potęguje punkt o różnicę wykładników z planu, biorąc potęgę z tablicy,
+ * jeśli została policzona z góry.
+ * @param[in] pows : kolejne potęgi punktu, od zerowej
+ * @param[in] powers : liczba potęg w tablicy @p pows
+ * @param[in] gap : różnica wykładników
+ * @return `x^gap`
+ */
+static inline poly_coeff_t PlanPower(const poly_coeff_t pows[],
+                                     unsigned powers, poly_coeff_t gap);
+
+/**
+ * Przywraca postać normalną poziomu niebędącego liściem po zmianie jego
+ * współczynników w miejscu: usuwa jednomiany o zerowych współczynnikach,
+ * a poziom o samych stałych współczynnikach zamienia na liść lub stałą.
+ * @param[in,out] p : wielomian normalny, jedyny właściciel poziomu
  */
-static Poly PolyAddNoConsts(Poly *p, Poly *q);
+static void PolyLevelNormalize(Poly *p);
+
+/**
+ * Wylicza wyraz wolny wielomianu, czyli jego wartość, gdy wszystkie
+ * zmienne są równe zeru.
+ * @param[in] p : wielomian
+ * @return `p(0, 0, ...)`
+ */
+static poly_coeff_t PolyConstantTerm(const Poly *p);
 
 /**
  * Funkcja pomocnicza dla PolyCompose, dodatkowo zlicza, jak głęboko
@@ -111,47 +281,29 @@ static Poly PolyBinPower(const Poly *p, poly_exp_t n);
 
 void PolyDestroy(Poly *p)
 {
-    if (!PolyIsCoeff(p)) {
-        while (p->type.m != NULL) {
-            Mono *tmp = p->type.m;
-            p->type.m = p->type.m->next;
-            PolyDestroy(&tmp->p);
-            free(tmp);
-        }
+    if (PolyIsCoeff(p) || PolyIsZero(p)) {
+        return;
+    }
+    if (reclaim_active) {
+        ReclaimRelease(*p);
+    }
+    else {
+        PolyFreeLevels(*p, false);
     }
 }
 
 Poly PolyClone(const Poly *p)
 {
-    Poly p_clone;
-    Mono *doll, *tmp, *wanderer, *helper;
-
-    if (PolyIsCoeff(p)) {
-        return PolyFromCoeff(p->type.c);
-    }
-    else {
-        tmp = p->type.m;
-        doll = MonoEmpty(-1);
-        wanderer = doll;
-        while (tmp != NULL) {
-            helper = MonoEmpty(tmp->exp);
-            helper->p = PolyClone(&tmp->p);
-            wanderer->next = helper;
-            wanderer = helper;
-            tmp = tmp->next;
-        }
-        p_clone.tag = p->tag;
-        p_clone.type.m = doll->next;
-        PolyDestroyMono(doll);
-        return p_clone;
+    if (!PolyIsZero(p) && !PolyIsCoeff(p)) {
+        RefsAcquire(PolyRefs(p));
     }
+    return *p;
 }
 
 Poly PolyAdd(const Poly *p, const Poly *q)
 {
-    Mono *mono_zero, *doll, *wanderer, *new_mono,
-            *mono_p, *mono_q;
-    Poly added, new;
+    Mono *doll, *wanderer, *new_mono, *mono_p, *mono_q;
+    Poly added, new, coeff_p, coeff_q;
 
     if (PolyIsZero(p)) {
         return PolyClone(q);
@@ -160,27 +312,21 @@ Poly PolyAdd(const Poly *p, const Poly *q)
         return PolyClone(p);
     }
     else if (PolyIsCoeff(p) && PolyIsCoeff(q)) {
-        if (p->type.c + q->type.c != 0) {
-            return PolyFromCoeff(p->type.c + q->type.c);
+        if (CoeffAdd(p->type.c, q->type.c) != 0) {
+            return PolyFromCoeff(CoeffAdd(p->type.c, q->type.c));
         }
         else {
             return PolyZero();
         }
     }
-    else if (PolyIsCoeff(p) || PolyIsCoeff(q)) {
-        mono_zero = MonoEmpty(0);
-        new.tag = COMPLEX;
-        new.type.m = mono_zero;
-        if (PolyIsCoeff(p)) {
-            mono_zero->p = PolyFromCoeff(p->type.c);
-            added = PolyAdd(&new, q);
-        }
-        else {
-            mono_zero->p = PolyFromCoeff(q->type.c);
-            added = PolyAdd(&new, p);
-        }
-        PolyDestroy(&new);
-        return added;
+    else if (p->tag == LEAF || q->tag == LEAF) {
+        return PolyInterned(PolyAddLeaf(p, q));
+    }
+    else if (PolyIsCoeff(p)) {
+        return PolyAddScalar(q, p->type.c);
+    }
+    else if (PolyIsCoeff(q)) {
+        return PolyAddScalar(p, q->type.c);
     }
     else {
         doll = MonoEmpty(-2);
@@ -189,174 +335,486 @@ Poly PolyAdd(const Poly *p, const Poly *q)
         mono_q = q->type.m;
         while (mono_p != NULL && mono_q != NULL) {
             new_mono = MonoEmpty(-2);
+            coeff_p = MonoGetPoly(mono_p);
+            coeff_q = MonoGetPoly(mono_q);
             if (mono_p->exp != mono_q->exp) {
                 if (mono_p->exp < mono_q->exp) {
                     new_mono->exp = mono_p->exp;
-                    new_mono->p = PolyClone(&mono_p->p);
-                    mono_p = mono_p->next;
+                    MonoSetPoly(new_mono, PolyClone(&coeff_p));
+                    mono_p = MonoNext(mono_p);
                 }
                 else {
                     new_mono->exp = mono_q->exp;
-                    new_mono->p = PolyClone(&mono_q->p);
-                    mono_q = mono_q->next;
+                    MonoSetPoly(new_mono, PolyClone(&coeff_q));
+                    mono_q = MonoNext(mono_q);
                 }
-                wanderer->next = new_mono;
-                wanderer = wanderer->next;
+                MonoSetNext(wanderer, new_mono);
+                wanderer = new_mono;
             }
             else {
-                new_mono->p = PolyAdd(&mono_p->p, &mono_q->p);
-                if (PolyIsZero(&new_mono->p)) {
-                    PolyDestroyMono(new_mono);
+                new = PolyAdd(&coeff_p, &coeff_q);
+                if (PolyIsZero(&new)) {
+                    MonoFree(new_mono);
                 }
                 else {
                     new_mono->exp = mono_p->exp;
-                    wanderer->next = new_mono;
-                    wanderer = wanderer->next;
+                    MonoSetPoly(new_mono, new);
+                    MonoSetNext(wanderer, new_mono);
+                    wanderer = new_mono;
                 }
-                mono_p = mono_p->next;
-                mono_q = mono_q->next;
+                mono_p = MonoNext(mono_p);
+                mono_q = MonoNext(mono_q);
             }
         }
         if (mono_p != NULL || mono_q != NULL) {
-            MonoComplete(&wanderer, mono_p);
-            MonoComplete(&wanderer, mono_q);
+            MonoComplete(&wanderer, mono_p, PolyClone);
+            MonoComplete(&wanderer, mono_q, PolyClone);
         }
-        wanderer = doll->next;
+        wanderer = MonoNext(doll);
         PolyDestroyMono(doll);
         added = PolyChoose(wanderer);
-        return added;
+        return PolyInterned(added);
     }
 }
 
 Poly PolyAddMonos(unsigned count, const Mono monos[])
 {
-    Poly p;
-    Mono *doll, *backer, *wanderer, *newMono;
-    unsigned i = 0;
+    unsigned i, length = 0;
+    unsigned j;
     Mono *tmp = (Mono*) monos;
+    PolyBucket bucket;
+    Poly current;
 
     qsort(tmp, count, sizeof(Mono), MonoExpComparator);
-    doll = MonoEmpty(-2);
-    backer = NULL;
-    wanderer = doll;
-    while (i < count) {
-        if (!PolyIsZero(&tmp[i].p)) {
-            if (wanderer->exp != tmp[i].exp) {
-                newMono = MonoEmpty(tmp[i].exp);
-                newMono->p = tmp[i].p;
-                wanderer->next = newMono;
-                backer = wanderer;
-                wanderer = wanderer->next;
-            }
-            else {
-                wanderer->p = PolyAddNoConsts(&wanderer->p, &tmp[i].p);
-                if (PolyIsZero(&wanderer->p)) {
-                    PolyDestroyMono(wanderer);
-                    wanderer = backer;
-                    wanderer->next = NULL;
-                }
+    for (i = 0; i < count; i = j) {
+        for (j = i + 1; j < count && tmp[j].exp == tmp[i].exp; j++) {
+        }
+        if (j - i == 1) {
+            current = MonoGetPoly(&tmp[i]);
+        }
+        else {
+            PolyBucketInit(&bucket);
+            for (unsigned k = i; k < j; k++) {
+                current = MonoGetPoly(&tmp[k]);
+                PolyBucketAdd(&bucket, &current);
             }
+            current = PolyBucketSum(&bucket);
+        }
+        if (!PolyIsZero(&current)) {
+            tmp[length] = MonoFromPoly(&current, tmp[i].exp);
+            length++;
         }
-        i++;
     }
-    wanderer = doll->next;
-    free(doll);
-    p = PolyChoose(wanderer);
-    return p;
+    return PolyInterned(PolyFromMonoArray(length, tmp));
 }
 
 
-Poly PolyMul(const Poly *p, const Poly *q)
+Poly PolyNeg(const Poly *p)
+{
+    if (PolyIsCoeff(p)) {
+        return PolyFromCoeff(CoeffMul(p->type.c, -1));
+    }
+    else if (p->tag == LEAF) {
+        return LeafNeg(p->type.l);
+    }
+    else if (p->tag == ARRAY) {
+        return PolyArrayMap(p, PolyNeg);
+    }
+    else {
+        return PolyListMap(p, PolyNeg);
+    }
+}
+
+Poly PolyMulScalar(const Poly *p, poly_coeff_t c)
 {
-    Poly to_multiply, score, tmp;
-    Mono *monoZero, *header_p, *header_q;
-    poly_exp_t counter, counter1 = 0, counter2 = 0;
+    RegionMark mark;
+    Mono *monos;
+    const Mono *m;
+    unsigned length = 0;
+    Poly coeff, scaled;
 
-    if (PolyIsZero(p) || PolyIsZero(q)) {
+    if (PolyIsCoeff(p)) {
+        return PolyFromCoeff(CoeffMul(p->type.c, c));
+    }
+    else if (c == 0) {
         return PolyZero();
     }
-    else if (PolyIsCoeff(p) || PolyIsCoeff(q)) {
-        if (PolyIsCoeff(p) && PolyIsCoeff(q)) {
-            return PolyFromCoeff(p->type.c * q->type.c);
+    else if (c == 1) {
+        return PolyClone(p);
+    }
+    else if (p->tag == LEAF) {
+        return PolyInterned(LeafScale(p->type.l, c));
+    }
+    mark = RegionSave();
+    monos = (Mono*) RegionAlloc(sizeof(Mono) * MonoCountBlocks(p->type.m));
+    for (m = p->type.m; m != NULL; m = MonoNext(m)) {
+        coeff = MonoGetPoly(m);
+        scaled = PolyMulScalar(&coeff, c);
+        if (!PolyIsZero(&scaled)) {
+            monos[length++] = MonoFromPoly(&scaled, m->exp);
         }
-        else {
-            monoZero = MonoEmpty(0);
-            to_multiply.tag = COMPLEX;
-            to_multiply.type.m = monoZero;
-            if (PolyIsCoeff(p)) {
-                monoZero->p = PolyFromCoeff(p->type.c);
-                score = PolyMul(&to_multiply, q);
-            }
-            else {
-                monoZero->p = PolyFromCoeff(q->type.c);
-                score = PolyMul(&to_multiply, p);
+    }
+    scaled = PolyFromMonoArray(length, monos);
+    RegionRestore(mark);
+    return PolyInterned(scaled);
+}
+
+void PolyMulScalarInPlace(Poly *p, poly_coeff_t c)
+{
+    PolyLeaf *leaf;
+    unsigned k = 0;
+    Mono *m;
+    Poly coeff, scaled;
+
+    if (PolyIsCoeff(p)) {
+        p->type.c = CoeffMul(p->type.c, c);
+        return;
+    }
+    else if (c == 1) {
+        return;
+    }
+    else if (c == 0 || *PolyRefs(p) != 1) {
+        scaled = PolyMulScalar(p, c);
+        PolyDestroy(p);
+        *p = scaled;
+        return;
+    }
+    else if (p->tag == LEAF) {
+        leaf = p->type.l;
+        for (unsigned i = 0; i < leaf->count; i++) {
+            if (CoeffMul(leaf->coeffs[i], c) != 0) {
+                LeafExps(leaf)[k] = LeafExps(leaf)[i];
+                leaf->coeffs[k++] = CoeffMul(leaf->coeffs[i], c);
             }
-            PolyDestroy(&to_multiply);
-            return score;
         }
+        *p = LeafFinish(leaf, k);
+        return;
+    }
+    for (m = p->type.m; m != NULL; m = MonoNext(m)) {
+        coeff = MonoGetPoly(m);
+        PolyMulScalarInPlace(&coeff, c);
+        MonoSetPoly(m, coeff);
+    }
+    PolyLevelNormalize(p);
+}
+
+Poly PolyAddScalar(const Poly *p, poly_coeff_t c)
+{
+    RegionMark mark;
+    Mono *monos;
+    const Mono *m;
+    unsigned length = 0;
+    Poly coeff, sum;
+
+    if (PolyIsCoeff(p)) {
+        return PolyFromCoeff(CoeffAdd(p->type.c, c));
+    }
+    else if (c == 0) {
+        return PolyClone(p);
+    }
+    else if (p->tag == LEAF) {
+        return PolyInterned(LeafAddCoeff(p->type.l, c));
+    }
+    mark = RegionSave();
+    monos = (Mono*) RegionAlloc(sizeof(Mono) *
+                                (MonoCountBlocks(p->type.m) + 1));
+    m = p->type.m;
+    if (m->exp == 0) {
+        coeff = MonoGetPoly(m);
+        sum = PolyAddScalar(&coeff, c);
+        m = MonoNext(m);
     }
     else {
-        header_p = p->type.m;
-        header_q = q->type.m;
-        counter1 = MonoCountBlocks(header_p);
-        counter2 = MonoCountBlocks(header_q);
-        counter = counter1 * counter2;
-        Mono *monos = (Mono*) malloc(sizeof(Mono) * counter);
-        assert(monos != NULL);
-        poly_exp_t i = 0;
-        while (header_p != NULL) {
-            header_q = q->type.m;
-            while (header_q != NULL) {
-                tmp = PolyMul(&header_p->p, &header_q->p);
-                monos[i++] = MonoFromPoly(&tmp, header_p->exp + header_q->exp);
-                header_q = header_q->next;
+        sum = PolyFromCoeff(c);
+    }
+    if (!PolyIsZero(&sum)) {
+        monos[length++] = MonoFromPoly(&sum, 0);
+    }
+    for (; m != NULL; m = MonoNext(m)) {
+        coeff = MonoGetPoly(m);
+        coeff = PolyClone(&coeff);
+        monos[length++] = MonoFromPoly(&coeff, m->exp);
+    }
+    sum = PolyFromMonoArray(length, monos);
+    RegionRestore(mark);
+    return PolyInterned(sum);
+}
+
+void PolyAddScalarInPlace(Poly *p, poly_coeff_t c)
+{
+    PolyLeaf *leaf;
+    Mono *head;
+    Poly coeff, sum;
+
+    if (PolyIsCoeff(p)) {
+        p->type.c = CoeffAdd(p->type.c, c);
+        return;
+    }
+    else if (c == 0) {
+        return;
+    }
+    else if (*PolyRefs(p) == 1 && p->tag == LEAF &&
+             LeafExps(p->type.l)[0] == 0) {
+        leaf = p->type.l;
+        leaf->coeffs[0] = CoeffAdd(leaf->coeffs[0], c);
+        if (leaf->coeffs[0] == 0) {
+            memmove(leaf->coeffs, leaf->coeffs + 1,
+                    sizeof(poly_coeff_t) * (leaf->count - 1));
+            memmove(LeafExps(leaf), LeafExps(leaf) + 1,
+                    sizeof(poly_exp_t) * (leaf->count - 1));
+            *p = LeafFinish(leaf, leaf->count - 1);
+        }
+        return;
+    }
+    else if (*PolyRefs(p) == 1 && p->tag != LEAF && p->type.m->exp == 0) {
+        coeff = MonoGetPoly(p->type.m);
+        PolyAddScalarInPlace(&coeff, c);
+        MonoSetPoly(p->type.m, coeff);
+        if (PolyIsZero(&coeff)) {
+            PolyLevelNormalize(p);
+        }
+        return;
+    }
+    else if (*PolyRefs(p) == 1 && p->tag == COMPLEX) {
+        head = MonoEmpty(0);
+        MonoSetPoly(head, PolyFromCoeff(c));
+        MonoSetNext(head, p->type.m);
+        p->type.m = head;
+        return;
+    }
+    sum = PolyAddScalar(p, c);
+    PolyDestroy(p);
+    *p = sum;
+}
+
+Poly PolySub(const Poly *p, const Poly *q)
+{
+    Mono *doll, *wanderer, *new_mono, *mono_p, *mono_q;
+    Poly subbed, coeff_p, coeff_q;
+
+    if (PolyIsZero(q)) {
+        return PolyClone(p);
+    }
+    else if (PolyIsCoeff(q)) {
+        return PolyAddScalar(p, CoeffMul(q->type.c, -1));
+    }
+    else if (PolyIsCoeff(p)) {
+        subbed = PolyNeg(q);
+        PolyAddScalarInPlace(&subbed, p->type.c);
+        return PolyInterned(subbed);
+    }
+    else if (p->tag == LEAF || q->tag == LEAF) {
+        return PolyInterned(PolySubLeaf(p, q));
+    }
+    doll = MonoEmpty(-2);
+    wanderer = doll;
+    mono_p = p->type.m;
+    mono_q = q->type.m;
+    while (mono_p != NULL && mono_q != NULL) {
+        coeff_p = MonoGetPoly(mono_p);
+        coeff_q = MonoGetPoly(mono_q);
+        if (mono_p->exp < mono_q->exp) {
+            subbed = PolyClone(&coeff_p);
+            new_mono = MonoEmpty(mono_p->exp);
+            mono_p = MonoNext(mono_p);
+        }
+        else if (mono_p->exp > mono_q->exp) {
+            subbed = PolyNeg(&coeff_q);
+            new_mono = MonoEmpty(mono_q->exp);
+            mono_q = MonoNext(mono_q);
+        }
+        else {
+            subbed = PolySub(&coeff_p, &coeff_q);
+            new_mono = PolyIsZero(&subbed) ? NULL : MonoEmpty(mono_p->exp);
+            mono_p = MonoNext(mono_p);
+            mono_q = MonoNext(mono_q);
+        }
+        if (new_mono != NULL) {
+            MonoSetPoly(new_mono, subbed);
+            MonoSetNext(wanderer, new_mono);
+            wanderer = new_mono;
+        }
+    }
+    MonoComplete(&wanderer, mono_p, PolyClone);
+    MonoComplete(&wanderer, mono_q, PolyNeg);
+    wanderer = MonoNext(doll);
+    MonoFree(doll);
+    subbed = PolyChoose(wanderer);
+    return PolyInterned(subbed);
+}
+
+void PolySubInPlace(Poly *p, const Poly *q)
+{
+    Mono *doll, *wanderer, *new_mono, *mono_p, *mono_q, *next;
+    Poly diff, coeff_p, coeff_q;
+
+    if (p == q) {
+        PolyDestroy(p);
+        *p = PolyZero();
+        return;
+    }
+    else if (PolyIsZero(q)) {
+        return;
+    }
+    else if (PolyIsCoeff(q)) {
+        PolyAddScalarInPlace(p, CoeffMul(q->type.c, -1));
+        return;
+    }
+    else if (PolyIsCoeff(p) || p->tag == LEAF || q->tag == LEAF) {
+        diff = PolySub(p, q);
+        PolyDestroy(p);
+        *p = diff;
+        return;
+    }
+    PolyUnpack(p);
+    PolyUnshare(p);
+    doll = MonoEmpty(-2);
+    wanderer = doll;
+    mono_p = p->type.m;
+    mono_q = q->type.m;
+    while (mono_p != NULL && mono_q != NULL) {
+        if (mono_p->exp < mono_q->exp) {
+            MonoSetNext(wanderer, mono_p);
+            wanderer = mono_p;
+            mono_p = MonoNext(mono_p);
+        }
+        else if (mono_p->exp > mono_q->exp) {
+            coeff_q = MonoGetPoly(mono_q);
+            new_mono = MonoEmpty(mono_q->exp);
+            MonoSetPoly(new_mono, PolyNeg(&coeff_q));
+            MonoSetNext(wanderer, new_mono);
+            wanderer = new_mono;
+            mono_q = MonoNext(mono_q);
+        }
+        else {
+            next = MonoNext(mono_p);
+            coeff_p = MonoGetPoly(mono_p);
+            coeff_q = MonoGetPoly(mono_q);
+            PolySubInPlace(&coeff_p, &coeff_q);
+            if (PolyIsZero(&coeff_p)) {
+                MonoFree(mono_p);
             }
-            header_p = header_p->next;
+            else {
+                MonoSetPoly(mono_p, coeff_p);
+                MonoSetNext(wanderer, mono_p);
+                wanderer = mono_p;
+            }
+            mono_p = next;
+            mono_q = MonoNext(mono_q);
         }
-        Poly score2 = PolyAddMonos((unsigned)counter, monos);
-        free(monos);
-        return score2;
     }
+    MonoSetNext(wanderer, mono_p);
+    MonoComplete(&wanderer, mono_q, PolyNeg);
+    wanderer = MonoNext(doll);
+    MonoFree(doll);
+    *p = PolyChoose(wanderer);
 }
 
-Poly PolyNeg(const Poly *p)
+Poly PolyAddOwned(Poly *p, Poly *q)
 {
-    Poly p_neg;
-    Mono *doll, *tmp, *wanderer, *helper;
+    Poly sum = PolyAddNoConsts(p, q);
+
+    *p = PolyZero();
+    *q = PolyZero();
+    return PolyInterned(sum);
+}
+
+Poly PolySubOwned(Poly *p, Poly *q)
+{
+    Poly diff;
+
+    PolySubInPlace(p, q);
+    PolyDestroy(q);
+    diff = *p;
+    *p = PolyZero();
+    *q = PolyZero();
+    return PolyInterned(diff);
+}
+
+Poly PolyMulOwned(Poly *p, Poly *q)
+{
+    Poly product;
 
     if (PolyIsCoeff(p)) {
-        return PolyFromCoeff(p->type.c * (-1));
+        PolyMulScalarInPlace(q, p->type.c);
+        product = *q;
+    }
+    else if (PolyIsCoeff(q)) {
+        PolyMulScalarInPlace(p, q->type.c);
+        product = *p;
     }
     else {
-        tmp = p->type.m;
-        doll = MonoEmpty(-1);
-        wanderer = doll;
-        while (tmp != NULL) {
-            helper = MonoEmpty(tmp->exp);
-            helper->p = PolyNeg(&tmp->p);
-            wanderer->next = helper;
-            wanderer = helper;
-            tmp = tmp->next;
-        }
-        p_neg.tag = p->tag;
-        p_neg.type.m = doll->next;
-        PolyDestroyMono(doll);
-        return p_neg;
+        product = PolyMul(p, q);
+        PolyDestroy(p);
+        PolyDestroy(q);
     }
+    *p = PolyZero();
+    *q = PolyZero();
+    return PolyInterned(product);
 }
 
-Poly PolySub(const Poly *p, const Poly *q)
+void PolyNegInPlace(Poly *p)
+{
+    PolyMulScalarInPlace(p, -1);
+    *p = PolyInterned(*p);
+}
+
+void PolyBucketInit(PolyBucket *b)
+{
+    for (unsigned i = 0; i < POLY_BUCKETS; i++) {
+        b->buckets[i] = PolyZero();
+        b->sizes[i] = 0;
+    }
+    b->constant = 0;
+}
+
+void PolyBucketAdd(PolyBucket *b, Poly *p)
+{
+    unsigned i;
+    size_t size;
+
+    if (PolyIsCoeff(p)) {
+        b->constant = CoeffAdd(b->constant, p->type.c);
+        *p = PolyZero();
+        return;
+    }
+    else if (PolyIsZero(p)) {
+        return;
+    }
+    size = PolyTermCount(p);
+    i = PolyBucketIndex(size);
+    b->buckets[i] = PolyAddNoConsts(&b->buckets[i], p);
+    *p = PolyZero();
+    b->sizes[i] = PolyTermCount(&b->buckets[i]);
+    while (i + 1 < POLY_BUCKETS && PolyBucketIndex(b->sizes[i]) > i) {
+        b->buckets[i + 1] = PolyAddNoConsts(&b->buckets[i + 1],
+                                            &b->buckets[i]);
+        b->buckets[i] = PolyZero();
+        b->sizes[i] = 0;
+        i++;
+        b->sizes[i] = PolyTermCount(&b->buckets[i]);
+    }
+}
+
+Poly PolyBucketSum(PolyBucket *b)
 {
-    Poly q_neg = PolyNeg(q);
-    Poly subbed = PolyAdd(p, &q_neg);
-    PolyDestroy(&q_neg);
-    return subbed;
+    Poly sum = PolyZero();
+
+    for (unsigned i = 0; i < POLY_BUCKETS; i++) {
+        sum = PolyAddNoConsts(&sum, &b->buckets[i]);
+        b->buckets[i] = PolyZero();
+        b->sizes[i] = 0;
+    }
+    PolyAddScalarInPlace(&sum, b->constant);
+    b->constant = 0;
+    return PolyInterned(sum);
 }
 
 poly_exp_t PolyDegBy(const Poly *p, unsigned var_idx)
 {
     poly_exp_t deg = -2, y;
     Mono *helper;
+    Poly coeff;
 
     if (PolyIsZero(p)) {
         return -1;
@@ -364,21 +822,25 @@ poly_exp_t PolyDegBy(const Poly *p, unsigned var_idx)
     else if (PolyIsCoeff(p)) {
         return 0;
     }
+    else if (p->tag == LEAF) {
+        return var_idx == 0 ? LeafExps(p->type.l)[p->type.l->count - 1] : 0;
+    }
     else if (var_idx == 0) {
         helper = p->type.m;
-        while (helper->next != NULL) {
-            helper = helper->next;
+        while (MonoNext(helper) != NULL) {
+            helper = MonoNext(helper);
         }
         return helper->exp;
     }
     else {
         helper = p->type.m;
         while (helper != NULL) {
-            y = PolyDegBy(&helper->p, var_idx - 1);
+            coeff = MonoGetPoly(helper);
+            y = PolyDegBy(&coeff, var_idx - 1);
             if (y > deg) {
                 deg = y;
             }
-            helper = helper->next;
+            helper = MonoNext(helper);
         }
         return deg;
     }
@@ -388,6 +850,7 @@ poly_exp_t PolyDeg(const Poly *p)
 {
     poly_exp_t deg = -2, current;
     Mono *header;
+    Poly coeff;
 
     if (PolyIsZero(p)) {
         return -1;
@@ -395,24 +858,111 @@ poly_exp_t PolyDeg(const Poly *p)
     else if (PolyIsCoeff(p)) {
         return 0;
     }
+    else if (p->tag == LEAF) {
+        return LeafExps(p->type.l)[p->type.l->count - 1];
+    }
     else {
         header = p->type.m;
         while (header != NULL) {
-            current = PolyDeg(&header->p);
+            coeff = MonoGetPoly(header);
+            current = PolyDeg(&coeff);
             current += header->exp;
             if (current > deg) {
                 deg = current;
             }
-            header = header->next;
+            header = MonoNext(header);
         }
         return deg;
     }
 }
 
+PolyMemInfo PolyMemStats(const Poly *p)
+{
+    return PolyMemStatsMany(1, p);
+}
+
+PolyMemInfo PolyMemStatsMany(size_t count, const Poly polys[])
+{
+    PolyMemInfo info = {0, 0, 0, 0};
+    struct {
+        Poly level;
+        unsigned depth;
+    } item, child;
+    WorkStack pending;
+    LevelSet seen = {NULL, 0, 0};
+    Mono *helper;
+    size_t length;
+    int visit;
+
+    WorkStackInit(&pending, sizeof(item));
+    for (size_t i = 0; i < count; i++) {
+        if (!PolyIsZero(&polys[i]) && !PolyIsCoeff(&polys[i])) {
+            item.level = polys[i];
+            item.depth = 1;
+            WorkStackPush(&pending, &item);
+        }
+    }
+    while (WorkStackPop(&pending, &item)) {
+        visit = LevelSetVisit(&seen, item.level.tag == LEAF
+                                     ? (const void*) item.level.type.l
+                                     : (const void*) item.level.type.m,
+                              item.depth);
+        if (visit < 0) {
+            continue;
+        }
+        if (item.depth > info.depth) {
+            info.depth = item.depth;
+        }
+        if (item.level.tag == LEAF) {
+            if (visit > 0) {
+                info.nodes += item.level.type.l->count;
+                info.leaves++;
+                info.bytes += MemPoolBlockSize(
+                        LeafSize(item.level.type.l->count));
+            }
+            continue;
+        }
+        length = 0;
+        for (helper = item.level.type.m; helper != NULL;
+             helper = MonoNext(helper)) {
+            length++;
+            child.level = MonoGetPoly(helper);
+            child.depth = item.depth + 1;
+            if (!PolyIsCoeff(&child.level)) {
+                WorkStackPush(&pending, &child);
+            }
+        }
+        if (visit > 0) {
+            info.nodes += length;
+            info.bytes += item.level.tag == ARRAY
+                          ? MemPoolBlockSize(sizeof(Mono) * length)
+                          : MemPoolBlockSize(sizeof(Mono)) * length;
+        }
+    }
+    WorkStackFree(&pending);
+    free(seen.slots);
+    return info;
+}
+
 bool PolyIsEq(const Poly *p, const Poly *q)
+{
+    WorkStack pending;
+    Poly pair[2] = {*p, *q};
+    bool is_eq;
+
+    WorkStackInit(&pending, sizeof(pair));
+    do {
+        is_eq = PolyLevelIsEq(&pair[0], &pair[1], &pending);
+    } while (is_eq && WorkStackPop(&pending, pair));
+    WorkStackFree(&pending);
+    return is_eq;
+}
+
+static bool PolyLevelIsEq(const Poly *p, const Poly *q, WorkStack *pending)
 {
     bool is_eq;
     Mono *tmp_p, *tmp_q;
+    Poly pair[2];
 
     if (PolyIsZero(p) || PolyIsZero(q)) {
         is_eq = PolyIsZero(p) && PolyIsZero(q);
@@ -425,6 +975,18 @@ bool PolyIsEq(const Poly *p, const Poly *q)
             is_eq = p->type.c == q->type.c;
         }
     }
+    else if (p->type.m == q->type.m) {
+        is_eq = true;
+    }
+    else if (PolyIsInterned(p) && PolyIsInterned(q)) {
+        is_eq = false;
+    }
+    else if (p->tag == LEAF) {
+        is_eq = LeafIsEq(p->type.l, q);
+    }
+    else if (q->tag == LEAF) {
+        is_eq = LeafIsEq(q->type.l, p);
+    }
     else {
         is_eq = true;
         tmp_p = p->type.m;
@@ -434,11 +996,16 @@ bool PolyIsEq(const Poly *p, const Poly *q)
             if (tmp_p->exp != tmp_q->exp) {
                 is_eq = false;
             }
+            else if (MonoIsCoeff(tmp_p) && MonoIsCoeff(tmp_q)) {
+                is_eq = tmp_p->coeff.c == tmp_q->coeff.c;
+            }
             else {
-                is_eq = PolyIsEq(&tmp_p->p, &tmp_q->p);
+                pair[0] = MonoGetPoly(tmp_p);
+                pair[1] = MonoGetPoly(tmp_q);
+                WorkStackPush(pending, pair);
             }
-            tmp_p = tmp_p->next;
-            tmp_q = tmp_q->next;
+            tmp_p = MonoNext(tmp_p);
+            tmp_q = MonoNext(tmp_q);
         }
         if (!(tmp_q == NULL && tmp_p == NULL && is_eq)) {
             is_eq = false;
@@ -449,9 +1016,11 @@ bool PolyIsEq(const Poly *p, const Poly *q)
 
 Poly PolyAt(const Poly *p, poly_coeff_t x)
 {
-    Poly atted, helper, number, tmp;
+    PolyBucket bucket;
+    Poly helper, tmp;
     Mono *header;
-    poly_coeff_t  counter = 0, multiplier;
+    poly_exp_t exp = 0;
+    poly_coeff_t multiplier = 1, counter = 0;
 
     if (PolyIsZero(p)) {
         return PolyZero();
@@ -459,59 +1028,482 @@ Poly PolyAt(const Poly *p, poly_coeff_t x)
     else if (PolyIsCoeff(p)) {
         return PolyFromCoeff(p->type.c);
     }
+    else if (p->tag == LEAF) {
+        return PolyFromCoeff(LeafAt(p->type.l, x));
+    }
     else {
-        atted = PolyZero();
+        PolyBucketInit(&bucket);
         header = p->type.m;
-        while (header != NULL) {
-            multiplier = PolyPower(x, header->exp);
-            if (PolyIsCoeff(&header->p)) {
-                counter += multiplier * header->p.type.c;
+        while (header != NULL && multiplier != 0) {
+            multiplier = CoeffMul(multiplier, PolyPower(x, header->exp - exp));
+            exp = header->exp;
+            if (MonoIsCoeff(header)) {
+                counter = CoeffAdd(counter,
+                                   CoeffMul(multiplier, header->coeff.c));
             }
             else {
-                number = PolyFromCoeff(multiplier);
-                tmp = PolyMul(&number, &header->p);
-                atted = PolyAddNoConsts(&tmp, &atted);
+                helper = MonoGetPoly(header);
+                tmp = PolyMulScalar(&helper, multiplier);
+                PolyBucketAdd(&bucket, &tmp);
             }
-            header = header->next;
-        }
-        if (counter != 0) {
-            number = PolyFromCoeff(counter);
-            helper = PolyAdd(&number, &atted);
-            PolyDestroy(&atted);
-            atted = helper;
+            header = MonoNext(header);
         }
-        return atted;
+        tmp = PolyFromCoeff(counter);
+        PolyBucketAdd(&bucket, &tmp);
+        return PolyBucketSum(&bucket);
     }
 }
 
-void PolyPrint(const Poly *p)
+poly_coeff_t PolyEval(const Poly *p, unsigned n, const poly_coeff_t xs[])
 {
-    PolyPrintMain(p);
-    printf("\n");
-}
+    const Mono *header;
+    poly_exp_t exp = 0;
+    poly_coeff_t multiplier = 1, value = 0;
+    Poly coeff;
 
-static void PolyPrintMain(const Poly *p)
-{
+    if (PolyIsZero(p)) {
+        return 0;
+    }
+    else if (PolyIsCoeff(p)) {
+        return p->type.c;
+    }
+    else if (n == 0) {
+        return PolyConstantTerm(p);
+    }
+    else if (p->tag == LEAF) {
+        return LeafAt(p->type.l, xs[0]);
+    }
+    header = p->type.m;
+    while (header != NULL && multiplier != 0) {
+        multiplier = CoeffMul(multiplier, PolyPower(xs[0], header->exp - exp));
+        exp = header->exp;
+        coeff = MonoGetPoly(header);
+        value = CoeffAdd(value,
+                         CoeffMul(multiplier, PolyEval(&coeff, n - 1, xs + 1)));
+        header = MonoNext(header);
+    }
+    return value;
+}
+
+bool PolyAtMany(const Poly *p, size_t k, const poly_coeff_t xs[],
+                poly_coeff_t out[])
+{
+    if (!PolyIsCoeff(p) && p->tag != LEAF && !MonoAllCoeffs(p->type.m)) {
+        return false;
+    }
+    PolyEvalMany(p, 1, k, xs, out);
+    return true;
+}
+
+bool PolyAtManyTree(const Poly *p, size_t k, const poly_coeff_t xs[],
+                    poly_coeff_t out[])
+{
+    Poly leaf;
+
+    if (PolyIsCoeff(p)) {
+        return PolyAtMany(p, k, xs, out);
+    }
+    else if (p->tag != LEAF && !MonoAllCoeffs(p->type.m)) {
+        return false;
+    }
+    leaf = p->tag == LEAF ? PolyClone(p) : LeafFromMonos(p->type.m);
+    eval_stats.tree_calls++;
+    LeafAtManyTree(leaf.type.l, k, xs, out);
+    PolyDestroy(&leaf);
+    return true;
+}
+
+void PolyEvalMany(const Poly *p, unsigned n, size_t k,
+                  const poly_coeff_t xs[], poly_coeff_t out[])
+{
+    RegionMark mark;
+    unsigned long *pw, *values;
+    const Mono *header;
+    poly_exp_t exp = 0;
+    poly_coeff_t c;
+    Poly coeff;
+
+    if (PolyIsCoeff(p) || n == 0) {
+        c = PolyIsCoeff(p) ? p->type.c : PolyConstantTerm(p);
+        for (size_t j = 0; j < k; j++) {
+            out[j] = c;
+        }
+    }
+    else if (p->tag == LEAF && MultipointPays(p->type.l, k)) {
+        eval_stats.tree_calls++;
+        LeafAtManyTree(p->type.l, k, xs, out);
+    }
+    else if (p->tag == LEAF) {
+        eval_stats.batch_calls++;
+        BatchHorner((const unsigned long*) p->type.l->coeffs,
+                    LeafExps(p->type.l), p->type.l->count, k,
+                    (const unsigned long*) xs, (unsigned long*) out);
+    }
+    else {
+        mark = RegionSave();
+        pw = (unsigned long*) RegionAlloc(sizeof(unsigned long) * k);
+        values = (unsigned long*) RegionAlloc(sizeof(unsigned long) * k);
+        for (size_t j = 0; j < k; j++) {
+            pw[j] = 1;
+            out[j] = 0;
+        }
+        for (header = p->type.m; header != NULL; header = MonoNext(header)) {
+            BatchPowerStep(k, (const unsigned long*) xs,
+                           (unsigned) (header->exp - exp), pw);
+            exp = header->exp;
+            if (MonoIsCoeff(header)) {
+                BatchMulAddCoeff(k, pw, (unsigned long) header->coeff.c,
+                                 (unsigned long*) out);
+            }
+            else {
+                coeff = MonoGetPoly(header);
+                PolyEvalMany(&coeff, n - 1, k, xs + k,
+                             (poly_coeff_t*) values);
+                BatchMulAdd(k, pw, values, (unsigned long*) out);
+            }
+        }
+        RegionRestore(mark);
+    }
+}
+
+PolyEvalStats PolyEvalGetStats(void)
+{
+    return eval_stats;
+}
+
+PolyEvalPlan PolyCompileEval(const Poly *p)
+{
+    RegionMark mark = RegionSave();
+    PolyEvalPlan plan = {.code = NULL, .length = 0, .depth = 0,
+                         .powers = 0};
+    WorkStack code;
+
+    WorkStackInit(&code, sizeof(poly_coeff_t));
+    PlanCompileLevel(p, 0, &code, &plan);
+    plan.powers = plan.powers > 2 ? plan.powers : 2;
+    if (code.size > 0) {
+        plan.code = (poly_coeff_t*) malloc(sizeof(poly_coeff_t) * code.size);
+        assert(plan.code != NULL);
+        memcpy(plan.code, code.items, sizeof(poly_coeff_t) * code.size);
+        plan.length = code.size;
+    }
+    WorkStackFree(&code);
+    RegionRestore(mark);
+    return plan;
+}
+
+poly_coeff_t PolyEvalCompiled(const PolyEvalPlan *plan, unsigned n,
+                              const poly_coeff_t xs[])
+{
+    RegionMark mark = RegionSave();
+    const poly_coeff_t *pc = plan->code, *end = plan->code + plan->length;
+    poly_coeff_t *acc, *table, *pows, value;
+    unsigned level = 0, powers = plan->powers;
+    size_t count;
+
+    acc = (poly_coeff_t*) RegionAlloc(sizeof(poly_coeff_t) *
+                                      (plan->depth + 1));
+    table = (poly_coeff_t*) RegionAlloc(sizeof(poly_coeff_t) *
+                                        (plan->depth + 1) * powers);
+    for (unsigned l = 0; l <= plan->depth; l++) {
+        pows = table + l * powers;
+        for (unsigned g = 0; g < powers; g++) {
+            pows[g] = g == 0 ? 1 : CoeffMul(pows[g - 1], l < n ? xs[l] : 0);
+        }
+    }
+    pows = table;
+    acc[0] = 0;
+    while (pc < end) {
+        switch ((enum PlanOp) pc[0]) {
+            case PLAN_RUN:
+                count = (size_t) pc[1];
+                value = acc[level];
+                for (pc += 2; count > 0; count--, pc += 2) {
+                    value = CoeffMul(value, PlanPower(pows, powers, pc[0]));
+                    value = CoeffAdd(value, pc[1]);
+                }
+                acc[level] = value;
+                break;
+            case PLAN_OPEN:
+                level++;
+                acc[level] = 0;
+                pows += powers;
+                pc++;
+                break;
+            case PLAN_CLOSE:
+                value = acc[level];
+                level--;
+                pows -= powers;
+                acc[level] = CoeffAdd(CoeffMul(acc[level],
+                                               PlanPower(pows, powers, pc[1])),
+                                      value);
+                pc += 2;
+                break;
+            case PLAN_SHIFT:
+                acc[level] = CoeffMul(acc[level],
+                                      PlanPower(pows, powers, pc[1]));
+                pc += 2;
+                break;
+        }
+    }
+    value = acc[0];
+    RegionRestore(mark);
+    return value;
+}
+
+void PolyEvalPlanDestroy(PolyEvalPlan *plan)
+{
+    free(plan->code);
+    plan->code = NULL;
+    plan->length = 0;
+    plan->depth = 0;
+    plan->powers = 0;
+}
+
+static void PlanEmit(WorkStack *code, poly_coeff_t word)
+{
+    WorkStackPush(code, &word);
+}
+
+static void PlanEmitGap(WorkStack *code, PolyEvalPlan *plan, poly_exp_t gap)
+{
+    if (gap < PLAN_POWERS && (unsigned) gap >= plan->powers) {
+        plan->powers = (unsigned) gap + 1;
+    }
+    PlanEmit(code, gap);
+}
+
+static void PlanCompileLevel(const Poly *p, unsigned level, WorkStack *code,
+                             PolyEvalPlan *plan)
+{
+    RegionMark mark;
+    const PolyLeaf *leaf;
+    const poly_exp_t *exps;
+    const Mono **monos;
+    const Mono *header;
+    size_t count = 0, run = 0;
+    poly_exp_t above = 0;
+    Poly coeff;
+
+    if (PolyIsZero(p)) {
+        return;
+    }
+    else if (PolyIsCoeff(p)) {
+        PlanEmit(code, PLAN_RUN);
+        PlanEmit(code, 1);
+        PlanEmit(code, 0);
+        PlanEmit(code, p->type.c);
+        return;
+    }
+    plan->depth = plan->depth > level + 1 ? plan->depth : level + 1;
+    if (p->tag == LEAF) {
+        leaf = p->type.l;
+        exps = LeafExps(leaf);
+        PlanEmit(code, PLAN_RUN);
+        PlanEmit(code, leaf->count);
+        for (unsigned i = leaf->count; i > 0; i--) {
+            PlanEmitGap(code, plan,
+                        i < leaf->count ? exps[i] - exps[i - 1] : 0);
+            PlanEmit(code, leaf->coeffs[i - 1]);
+        }
+        if (exps[0] > 0) {
+            PlanEmit(code, PLAN_SHIFT);
+            PlanEmitGap(code, plan, exps[0]);
+        }
+        return;
+    }
+    mark = RegionSave();
+    for (header = p->type.m; header != NULL; header = MonoNext(header)) {
+        count++;
+    }
+    monos = (const Mono**) RegionAlloc(sizeof(Mono*) * count);
+    count = 0;
+    for (header = p->type.m; header != NULL; header = MonoNext(header)) {
+        monos[count++] = header;
+    }
+    above = monos[count - 1]->exp;
+    for (size_t i = count; i > 0; i--) {
+        header = monos[i - 1];
+        if (MonoIsCoeff(header)) {
+            if (run == 0) {
+                PlanEmit(code, PLAN_RUN);
+                PlanEmit(code, 0);
+            }
+            run++;
+            PlanEmitGap(code, plan, above - header->exp);
+            PlanEmit(code, header->coeff.c);
+        }
+        else {
+            if (run > 0) {
+                ((poly_coeff_t*) code->items)[code->size - 2 * run - 1] =
+                    (poly_coeff_t) run;
+                run = 0;
+            }
+            coeff = MonoGetPoly(header);
+            PlanEmit(code, PLAN_OPEN);
+            PlanCompileLevel(&coeff, level + 1, code, plan);
+            PlanEmit(code, PLAN_CLOSE);
+            PlanEmitGap(code, plan, above - header->exp);
+        }
+        above = header->exp;
+    }
+    if (run > 0) {
+        ((poly_coeff_t*) code->items)[code->size - 2 * run - 1] =
+            (poly_coeff_t) run;
+    }
+    if (above > 0) {
+        PlanEmit(code, PLAN_SHIFT);
+        PlanEmitGap(code, plan, above);
+    }
+    RegionRestore(mark);
+}
+
+static inline poly_coeff_t PlanPower(const poly_coeff_t pows[],
+                                     unsigned powers, poly_coeff_t gap)
+{
+    return gap < powers ? pows[gap] : PolyPower(pows[1], (poly_exp_t) gap);
+}
+
+void PolyPrint(const Poly *p)
+{
+    PolyPrintMain(p);
+    printf("\n");
+}
+
+static bool PolyPrintFlat(const Poly *p)
+{
     if (PolyIsZero(p)) {
         printf("0");
     }
     else if (PolyIsCoeff(p)) {
         printf("%ld", p->type.c);
     }
+    else if (p->tag == LEAF) {
+        const poly_exp_t *exps = LeafExps(p->type.l);
+        for (unsigned i = 0; i < p->type.l->count; i++) {
+            printf(i == 0 ? "(%ld,%d)" : "+(%ld,%d)",
+                   p->type.l->coeffs[i], exps[i]);
+        }
+    }
     else {
-        Mono *helper = p->type.m;
-        if (helper->next != NULL ) {
-            while (helper->next != NULL) {
-                printf("(");
-                PolyPrintMain(&helper->p);
-                printf(",%d)+", helper->exp);
-                helper = helper->next;
+        return false;
+    }
+    return true;
+}
+
+static void PolyPrintMain(const Poly *p)
+{
+    WorkStack path;
+    Mono *helper;
+    Poly coeff;
+
+    if (PolyPrintFlat(p)) {
+        return;
+    }
+    WorkStackInit(&path, sizeof(Mono*));
+    helper = p->type.m;
+    while (true) {
+        if (helper != NULL) {
+            printf("(");
+            coeff = MonoGetPoly(helper);
+            if (!PolyPrintFlat(&coeff)) {
+                WorkStackPush(&path, &helper);
+                helper = coeff.type.m;
+                continue;
             }
         }
-        printf("(");
-        PolyPrintMain(&helper->p);
+        else if (!WorkStackPop(&path, &helper)) {
+            break;
+        }
         printf(",%d)", helper->exp);
+        helper = MonoNext(helper);
+        if (helper != NULL) {
+            printf("+");
+        }
     }
+    WorkStackFree(&path);
+}
+
+void WorkStackInit(WorkStack *ws, size_t elem)
+{
+    ws->items = ws->local;
+    ws->size = 0;
+    ws->capacity = WORK_STACK_LOCAL / elem;
+    ws->elem = elem;
+}
+
+void WorkStackPush(WorkStack *ws, const void *item)
+{
+    if (ws->size == ws->capacity) {
+        ws->capacity *= 2;
+        if (ws->items == ws->local) {
+            ws->items = (char*) malloc(ws->capacity * ws->elem);
+            assert(ws->items != NULL);
+            memcpy(ws->items, ws->local, ws->size * ws->elem);
+        }
+        else {
+            ws->items = (char*) realloc(ws->items, ws->capacity * ws->elem);
+            assert(ws->items != NULL);
+        }
+    }
+    memcpy(ws->items + ws->size * ws->elem, item, ws->elem);
+    ws->size++;
+}
+
+bool WorkStackPop(WorkStack *ws, void *item)
+{
+    if (ws->size == 0) {
+        return false;
+    }
+    ws->size--;
+    memcpy(item, ws->items + ws->size * ws->elem, ws->elem);
+    return true;
+}
+
+void WorkStackFree(WorkStack *ws)
+{
+    if (ws->items != ws->local) {
+        free(ws->items);
+    }
+}
+
+static int LevelSetVisit(LevelSet *set, const void *level, unsigned depth)
+{
+    LevelSlot *old = set->slots;
+    size_t old_capacity = set->capacity, i;
+
+    if (2 * (set->size + 1) > set->capacity) {
+        set->capacity = old_capacity == 0 ? LEVEL_SET_START
+                                          : 2 * old_capacity;
+        set->slots = (LevelSlot*) calloc(set->capacity, sizeof(LevelSlot));
+        assert(set->slots != NULL);
+        for (size_t j = 0; j < old_capacity; j++) {
+            if (old[j].level != NULL) {
+                i = ((uintptr_t) old[j].level >> 3) * 0x9e3779b97f4a7c15u &
+                    (set->capacity - 1);
+                while (set->slots[i].level != NULL) {
+                    i = (i + 1) & (set->capacity - 1);
+                }
+                set->slots[i] = old[j];
+            }
+        }
+        free(old);
+    }
+    i = ((uintptr_t) level >> 3) * 0x9e3779b97f4a7c15u & (set->capacity - 1);
+    while (set->slots[i].level != NULL && set->slots[i].level != level) {
+        i = (i + 1) & (set->capacity - 1);
+    }
+    if (set->slots[i].level == NULL) {
+        set->slots[i].level = level;
+        set->slots[i].depth = depth;
+        set->size++;
+        return 1;
+    }
+    if (set->slots[i].depth < depth) {
+        set->slots[i].depth = depth;
+        return 0;
+    }
+    return -1;
 }
 
 static Poly PolyBinPower(const Poly *p, poly_exp_t n)
@@ -526,10 +1518,12 @@ static Poly PolyBinPower(const Poly *p, poly_exp_t n)
             a = PolyMul(&a, &b);
             PolyDestroy(&a_tmp);
         }
-        b_tmp = b;
-        b = PolyMul(&b, &b);
-        PolyDestroy(&b_tmp);
         c /= 2;
+        if (c > 0) {
+            b_tmp = b;
+            b = PolySqr(&b);
+            PolyDestroy(&b_tmp);
+        }
     }
     PolyDestroy(&b);
     return a;
@@ -539,57 +1533,55 @@ static Poly PolyComposeHelper(const Poly *p, unsigned  i, unsigned count,
                               const Poly x[])
 {
     Mono *helper = p->type.m;
-    Poly *polys_array;
-    unsigned polys_length = 1, polys_count = 0;
+    PolyBucket bucket;
     poly_exp_t n;
-    Poly coeff, powered, result, result_tmp;
+    Poly coeff, powered, result;
 
     if (count == 0) {
-        while (helper->exp == 0 && !PolyIsCoeff(&helper->p) &&
-                helper->p.type.m->exp == 0) {
-            helper = helper->p.type.m;
-        }
-        if (helper->exp == 0 && PolyIsCoeff(&helper->p)) {
-            return PolyFromCoeff(helper->p.type.c);
-        }
-        else {
-            return PolyZero();
-        }
+        return PolyFromCoeff(PolyConstantTerm(p));
+    }
+    else if (p->tag == LEAF) {
+        coeff = LeafExpand(p);
+        result = PolyComposeHelper(&coeff, i, count, x);
+        PolyDestroy(&coeff);
+        return result;
     }
     else {
-        polys_array = (Poly*) malloc(sizeof(Poly) * polys_length);
+        PolyBucketInit(&bucket);
         while (helper != NULL) {
             n = helper->exp;
-            if (PolyIsCoeff(&helper->p)) {
-                coeff = PolyFromCoeff(helper->p.type.c);
-            }
-            else {
-                coeff = PolyComposeHelper(&helper->p, i + 1, count - 1, x);
+            coeff = MonoGetPoly(helper);
+            if (!PolyIsCoeff(&coeff)) {
+                coeff = PolyComposeHelper(&coeff, i + 1, count - 1, x);
             }
             if (!PolyIsZero(&coeff)) {
                 powered = PolyBinPower(&x[i], n);
                 result = PolyMul(&powered, &coeff);
                 PolyDestroy(&powered);
                 PolyDestroy(&coeff);
-                if (polys_count == polys_length) {
-                    polys_length *= 2;
-                    polys_array = (Poly *) realloc(polys_array,
-                                                   sizeof(Poly) * polys_length);
-                }
-                polys_array[polys_count++] = result;
+                PolyBucketAdd(&bucket, &result);
             }
-            helper = helper->next;
+            helper = MonoNext(helper);
+        }
+        return PolyBucketSum(&bucket);
+    }
+}
+
+static poly_coeff_t PolyConstantTerm(const Poly *p)
+{
+    Poly level = *p;
+
+    while (!PolyIsCoeff(&level) && !PolyIsZero(&level)) {
+        if (level.tag == LEAF) {
+            return LeafExps(level.type.l)[0] == 0 ?
+                   level.type.l->coeffs[0] : 0;
         }
-        result = PolyZero();
-        for (unsigned j = 0; j < polys_count; j++) {
-            result_tmp = result;
-            result = PolyAdd(&result, &polys_array[j]);
-            PolyDestroy(&result_tmp);
-            PolyDestroy(&(polys_array[j]));
+        else if (level.type.m->exp != 0) {
+            return 0;
         }
-        free(polys_array);
-        return result;
+        level = MonoGetPoly(level.type.m);
     }
+    return PolyIsZero(&level) ? 0 : level.type.c;
 }
 
 Poly PolyCompose(const Poly *p, unsigned count, const Poly x[])
@@ -604,19 +1596,23 @@ Poly PolyCompose(const Poly *p, unsigned count, const Poly x[])
 
 static void PolyDestroyMono(Mono *m)
 {
-    PolyDestroy(&m->p);
-    free(m);
+    MonoDestroy(m);
+    MonoFree(m);
+}
+
+static inline void MonoFree(Mono *m)
+{
+    MemPoolFree(m, sizeof(Mono));
 }
 
 static Mono *MonoEmpty(poly_exp_t x)
 {
-    Mono *empty = (Mono*) malloc(sizeof(Mono));
-    assert(empty != NULL);
+    Mono *empty = (Mono*) MemPoolAlloc(sizeof(Mono));
 
     empty->exp = x;
-    empty->next = NULL;
-    empty->p.tag = COMPLEX;
-    empty->p.type.m = NULL;
+    empty->refs = 1;
+    empty->link = (uintptr_t) COMPLEX;
+    empty->coeff.m = NULL;
     return empty;
 }
 
@@ -629,29 +1625,257 @@ static Poly PolyChoose(Mono *m)
     }
     else {
         if (m->exp == 0 &&
-            m->next == NULL &&
-            m->p.tag == SIMPLE) {
-            chosen_one = PolyFromCoeff(m->p.type.c);
+            MonoNext(m) == NULL &&
+            MonoIsCoeff(m)) {
+            chosen_one = PolyFromCoeff(m->coeff.c);
             PolyDestroyMono(m);
         }
+        else if (MonoAllCoeffs(m)) {
+            chosen_one = LeafFromMonos(m);
+            while (m != NULL) {
+                Mono *destroyer = m;
+                m = MonoNext(m);
+                MonoFree(destroyer);
+            }
+        }
         else {
+#ifdef POLY_ARRAY_LAYOUT
+            chosen_one = PolyPackList(m);
+#else
             chosen_one.type.m = m;
             chosen_one.tag = COMPLEX;
+#endif
         }
     }
     return chosen_one;
 }
 
-static void MonoComplete(Mono **toComplete, Mono *cloned)
+Mono *MonoArrayNew(unsigned count)
+{
+    Mono *arr = (Mono*) MemPoolAlloc(sizeof(Mono) * count);
+
+    for (unsigned i = 0; i < count; i++) {
+        arr[i].refs = 1;
+        arr[i].link = (uintptr_t) &arr[i + 1];
+    }
+    arr[count - 1].link = 0;
+    return arr;
+}
+
+static inline void MonoArrayFree(Mono *arr, unsigned count)
+{
+    MemPoolFree(arr, sizeof(Mono) * count);
+}
+
+Poly PolyFromMonoArray(unsigned count, const Mono monos[])
+{
+    Mono *arr;
+    PolyLeaf *leaf;
+    unsigned i = 0;
+
+    if (count == 0) {
+        return PolyZero();
+    }
+    else if (count == 1 && monos[0].exp == 0 && MonoIsCoeff(&monos[0])) {
+        return PolyFromCoeff(monos[0].coeff.c);
+    }
+    while (i < count && MonoIsCoeff(&monos[i])) {
+        i++;
+    }
+    if (i == count) {
+        leaf = LeafNew(count);
+        for (i = 0; i < count; i++) {
+            leaf->coeffs[i] = monos[i].coeff.c;
+            LeafExps(leaf)[i] = monos[i].exp;
+        }
+        return (Poly) {.tag = LEAF, .type.l = leaf};
+    }
+    else {
+        arr = MonoArrayNew(count);
+        for (unsigned i = 0; i < count; i++) {
+            arr[i].exp = monos[i].exp;
+            MonoSetPoly(&arr[i], MonoGetPoly(&monos[i]));
+        }
+        return (Poly) {.tag = ARRAY, .type.m = arr};
+    }
+}
+
+Poly PolyPackList(Mono *m)
+{
+    Mono *arr, *destroyer;
+    unsigned i = 0, count = (unsigned) MonoCountBlocks(m);
+    Poly packed;
+
+    if (count == 0) {
+        return PolyZero();
+    }
+    if (MonoAllCoeffs(m)) {
+        packed = LeafFromMonos(m);
+        while (m != NULL) {
+            destroyer = m;
+            m = MonoNext(m);
+            MonoFree(destroyer);
+        }
+        return packed;
+    }
+    arr = MonoArrayNew(count);
+    while (m != NULL) {
+        arr[i].exp = m->exp;
+        MonoSetPoly(&arr[i], MonoGetPoly(m));
+        i++;
+        destroyer = m;
+        m = MonoNext(m);
+        MonoFree(destroyer);
+    }
+    return (Poly) {.tag = ARRAY, .type.m = arr};
+}
+
+static void PolyUnpack(Poly *p)
+{
+    Mono *doll, *wanderer, *tmp;
+    unsigned count = 0;
+    bool shared;
+    Poly coeff;
+
+    if (p->tag == LEAF) {
+        shared = p->type.l->refs > 1;
+        doll = MonoEmpty(-1);
+        wanderer = doll;
+        for (unsigned i = 0; i < p->type.l->count; i++) {
+            MonoSetNext(wanderer, MonoEmpty(LeafExps(p->type.l)[i]));
+            wanderer = MonoNext(wanderer);
+            MonoSetPoly(wanderer, PolyFromCoeff(p->type.l->coeffs[i]));
+        }
+        if (shared) {
+            RefsRelease(&p->type.l->refs);
+        }
+        else {
+            LeafFree(p->type.l);
+        }
+        p->tag = COMPLEX;
+        p->type.m = MonoNext(doll);
+        MonoFree(doll);
+        return;
+    }
+    if (p->tag != ARRAY) {
+        return;
+    }
+    shared = p->type.m->refs > 1;
+    doll = MonoEmpty(-1);
+    wanderer = doll;
+    for (tmp = p->type.m; tmp != NULL; tmp = MonoNext(tmp)) {
+        MonoSetNext(wanderer, MonoEmpty(tmp->exp));
+        wanderer = MonoNext(wanderer);
+        coeff = MonoGetPoly(tmp);
+        MonoSetPoly(wanderer, shared ? PolyClone(&coeff) : coeff);
+        count++;
+    }
+    if (shared) {
+        RefsRelease(&p->type.m->refs);
+    }
+    else {
+        MonoArrayFree(p->type.m, count);
+    }
+    p->tag = COMPLEX;
+    p->type.m = MonoNext(doll);
+    MonoFree(doll);
+}
+
+static Poly PolyArrayMap(const Poly *p, Poly (*map)(const Poly *))
+{
+    Mono *arr, *tmp;
+    unsigned i = 0;
+    Poly coeff;
+
+    arr = MonoArrayNew((unsigned) MonoCountBlocks(p->type.m));
+    for (tmp = p->type.m; tmp != NULL; tmp = MonoNext(tmp)) {
+        arr[i].exp = tmp->exp;
+        coeff = MonoGetPoly(tmp);
+        MonoSetPoly(&arr[i], map(&coeff));
+        i++;
+    }
+    return (Poly) {.tag = ARRAY, .type.m = arr};
+}
+
+static Poly PolyListMap(const Poly *p, Poly (*map)(const Poly *))
+{
+    Poly mapped, coeff;
+    Mono *doll, *tmp, *wanderer, *helper;
+
+    tmp = p->type.m;
+    doll = MonoEmpty(-1);
+    wanderer = doll;
+    while (tmp != NULL) {
+        helper = MonoEmpty(tmp->exp);
+        coeff = MonoGetPoly(tmp);
+        MonoSetPoly(helper, map(&coeff));
+        MonoSetNext(wanderer, helper);
+        wanderer = helper;
+        tmp = MonoNext(tmp);
+    }
+    mapped.tag = COMPLEX;
+    mapped.type.m = MonoNext(doll);
+    MonoFree(doll);
+    return mapped;
+}
+
+void PolyUnshare(Poly *p)
+{
+    Poly copy;
+
+    if (PolyIsCoeff(p) || p->type.m == NULL || *PolyRefs(p) == 1) {
+        return;
+    }
+    if (p->tag == LEAF) {
+        copy.tag = LEAF;
+        copy.type.l = LeafNew(p->type.l->count);
+        memcpy(copy.type.l->coeffs, p->type.l->coeffs,
+               LeafSize(p->type.l->count) - sizeof(PolyLeaf));
+    }
+    else if (p->tag == ARRAY) {
+        copy = PolyArrayMap(p, PolyClone);
+    }
+    else {
+        copy = PolyListMap(p, PolyClone);
+    }
+    RefsRelease(PolyRefs(p));
+    *p = copy;
+}
+
+void PolyPack(Poly *p)
+{
+    Mono *m;
+    Poly coeff;
+
+    if (p->tag == LEAF) {
+        return;
+    }
+    PolyUnshare(p);
+    if (p->tag == COMPLEX) {
+        *p = PolyPackList(p->type.m);
+    }
+    if (p->tag == ARRAY) {
+        for (m = p->type.m; m != NULL; m = MonoNext(m)) {
+            coeff = MonoGetPoly(m);
+            PolyPack(&coeff);
+            MonoSetPoly(m, coeff);
+        }
+    }
+}
+
+static void MonoComplete(Mono **toComplete, Mono *cloned,
+                         Poly (*map)(const Poly *))
 {
     Mono *new_mono;
+    Poly coeff;
 
     while (cloned != NULL) {
         new_mono = MonoEmpty(cloned->exp);
-        new_mono->p = PolyClone(&cloned->p);
-        (*toComplete)->next = new_mono;
-        *toComplete = (*toComplete)->next;
-        cloned = cloned->next;
+        coeff = MonoGetPoly(cloned);
+        MonoSetPoly(new_mono, map(&coeff));
+        MonoSetNext(*toComplete, new_mono);
+        *toComplete = new_mono;
+        cloned = MonoNext(cloned);
     }
 }
 
@@ -662,27 +1886,53 @@ static poly_exp_t MonoExpComparator(const void *x1, const void *x2)
     return y1->exp - y2->exp;
 }
 
-static poly_exp_t MonoCountBlocks(const Mono *m)
+poly_exp_t MonoCountBlocks(const Mono *m)
 {
     poly_exp_t count = 0;
 
     while (m != NULL) {
         count++;
-        m = m->next;
+        m = MonoNext(m);
     }
     return count;
 }
 
-static poly_coeff_t PolyPower(poly_coeff_t x, poly_exp_t n)
+static size_t PolyTermCount(const Poly *p)
+{
+    if (PolyIsZero(p)) {
+        return 0;
+    }
+    else if (PolyIsCoeff(p)) {
+        return 1;
+    }
+    else if (p->tag == LEAF) {
+        return p->type.l->count;
+    }
+    else {
+        return (size_t) MonoCountBlocks(p->type.m);
+    }
+}
+
+static unsigned PolyBucketIndex(size_t size)
+{
+    unsigned i = 0;
+
+    while (i + 1 < POLY_BUCKETS && size > ((size_t) 4 << (2 * i))) {
+        i++;
+    }
+    return i;
+}
+
+poly_coeff_t PolyPower(poly_coeff_t x, poly_exp_t n)
 {
     poly_coeff_t a = 1, b = x;
     poly_exp_t c = n;
 
     while (c > 0) {
         if (c % 2 == 1) {
-            a *= b;
+            a = CoeffMul(a, b);
         }
-        b *= b;
+        b = CoeffMul(b, b);
         c = c / 2;
     }
     return a;
@@ -691,17 +1941,16 @@ static poly_coeff_t PolyPower(poly_coeff_t x, poly_exp_t n)
 static void MonoCompleteNoConsts(Mono *toComplete, Mono *cloned)
 {
     while (cloned != NULL) {
-        toComplete->next = cloned;
-        toComplete = toComplete->next;
-        cloned = cloned->next;
+        MonoSetNext(toComplete, cloned);
+        toComplete = cloned;
+        cloned = MonoNext(cloned);
     }
 }
 
-static Poly PolyAddNoConsts(Poly *p, Poly *q)
+Poly PolyAddNoConsts(Poly *p, Poly *q)
 {
-    Mono *mono_zero, *doll, *wanderer, *mono_p,
-        *mono_q, *destroyer_p, *destroyer_q;
-    Poly added, new, helper;
+    Mono *doll, *wanderer, *mono_p, *mono_q, *destroyer_p, *destroyer_q;
+    Poly added, helper, coeff_p, coeff_q;
 
     if (PolyIsZero(p) || PolyIsZero(q)) {
         if (PolyIsZero(p) && PolyIsZero(q)) {
@@ -715,29 +1964,33 @@ static Poly PolyAddNoConsts(Poly *p, Poly *q)
         }
     }
     else if (PolyIsCoeff(p) && PolyIsCoeff(q)) {
-        if (p->type.c + q->type.c != 0) {
-            return PolyFromCoeff(p->type.c + q->type.c);
+        if (CoeffAdd(p->type.c, q->type.c) != 0) {
+            return PolyFromCoeff(CoeffAdd(p->type.c, q->type.c));
         }
         else {
             return PolyZero();
         }
     }
-    else if (PolyIsCoeff(p) || PolyIsCoeff(q)) {
-        mono_zero = MonoEmpty(0);
-        new.tag = COMPLEX;
-        new.type.m = mono_zero;
-
-        if (PolyIsCoeff(p)) {
-            mono_zero->p = PolyFromCoeff(p->type.c);
-            added = PolyAddNoConsts(&new, q);
-        }
-        else {
-            mono_zero->p = PolyFromCoeff(q->type.c);
-            added = PolyAddNoConsts(&new, p);
-        }
+    else if ((PolyIsCoeff(p) || p->tag == LEAF) &&
+             (PolyIsCoeff(q) || q->tag == LEAF)) {
+        added = PolyAddLeaf(p, q);
+        PolyDestroy(p);
+        PolyDestroy(q);
         return added;
     }
+    else if (PolyIsCoeff(p)) {
+        PolyAddScalarInPlace(q, p->type.c);
+        return *q;
+    }
+    else if (PolyIsCoeff(q)) {
+        PolyAddScalarInPlace(p, q->type.c);
+        return *p;
+    }
     else {
+        PolyUnpack(p);
+        PolyUnpack(q);
+        PolyUnshare(p);
+        PolyUnshare(q);
         doll = MonoEmpty(-2);
         wanderer = doll;
         mono_p = p->type.m;
@@ -745,42 +1998,79 @@ static Poly PolyAddNoConsts(Poly *p, Poly *q)
         while (mono_p != NULL && mono_q != NULL) {
             if (mono_p->exp != mono_q->exp) {
                 if (mono_p->exp < mono_q->exp) {
-                    wanderer->exp = mono_p->exp;
-                    wanderer->next = mono_p;
-                    mono_p = mono_p->next;
+                    MonoSetNext(wanderer, mono_p);
+                    mono_p = MonoNext(mono_p);
                 }
                 else {
-                    wanderer->exp = mono_q->exp;
-                    wanderer->next = mono_q;
-                    mono_q = mono_q->next;
+                    MonoSetNext(wanderer, mono_q);
+                    mono_q = MonoNext(mono_q);
                 }
-                wanderer = wanderer->next;
+                wanderer = MonoNext(wanderer);
             }
             else {
-                helper = PolyAddNoConsts(&mono_p->p, &mono_q->p);
+                coeff_p = MonoGetPoly(mono_p);
+                coeff_q = MonoGetPoly(mono_q);
+                helper = PolyAddNoConsts(&coeff_p, &coeff_q);
                 destroyer_p = mono_p;
                 destroyer_q = mono_q;
-                mono_p = mono_p->next;
-                mono_q = mono_q->next;
+                mono_p = MonoNext(mono_p);
+                mono_q = MonoNext(mono_q);
                 if (PolyIsZero(&helper)) {
-                    free(destroyer_p);
-                    free(destroyer_q);
+                    MonoFree(destroyer_p);
+                    MonoFree(destroyer_q);
                 }
                 else {
-                    wanderer->next = destroyer_p;
-                    destroyer_p->p = helper;
-                    wanderer = wanderer->next;
-                    free(destroyer_q);
+                    MonoSetNext(wanderer, destroyer_p);
+                    MonoSetPoly(destroyer_p, helper);
+                    wanderer = destroyer_p;
+                    MonoFree(destroyer_q);
                 }
             }
         }
+        MonoSetNext(wanderer, NULL);
         if (mono_p != NULL || mono_q != NULL) {
             MonoCompleteNoConsts(wanderer, mono_p);
             MonoCompleteNoConsts(wanderer, mono_q);
         }
-        wanderer = doll->next;
-        free(doll);
+        wanderer = MonoNext(doll);
+        MonoFree(doll);
         added = PolyChoose(wanderer);
         return added;
     }
-}
\ No newline at end of file
+}
+
+static void PolyLevelNormalize(Poly *p)
+{
+    RegionMark mark;
+    Mono *m, *next, *monos;
+    unsigned count = 0, length = 0;
+    bool zeros = false, coeffs = true;
+    Poly coeff;
+
+    for (m = p->type.m; m != NULL; m = MonoNext(m)) {
+        coeff = MonoGetPoly(m);
+        zeros |= PolyIsZero(&coeff);
+        coeffs &= PolyIsCoeff(&coeff);
+        count++;
+    }
+    if (!zeros && !coeffs) {
+        return;
+    }
+    mark = RegionSave();
+    monos = (Mono*) RegionAlloc(sizeof(Mono) * count);
+    for (m = p->type.m; m != NULL; m = next) {
+        next = MonoNext(m);
+        coeff = MonoGetPoly(m);
+        if (!PolyIsZero(&coeff)) {
+            monos[length++] = MonoFromPoly(&coeff, m->exp);
+        }
+        if (p->tag == COMPLEX) {
+            MonoFree(m);
+        }
+    }
+    if (p->tag == ARRAY) {
+        MonoArrayFree(p->type.m, count);
+    }
+    *p = PolyFromMonoArray(length, monos);
+    RegionRestore(mark);
+}
@@ -11,6 +11,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <assert.h>
 #include <stdio.h>
 
@@ -22,36 +23,213 @@ typedef int poly_exp_t;
 
 /**
   * Wskaźnik typu wielomianu - wielomian może być stałą (SIMPLE)
-  * lub być wielomianem normalnym (COMPLEX)
+  * lub być wielomianem normalnym przechowywanym jako lista (COMPLEX)
+  * albo jako tablica jednomianów (ARRAY); wielomian, którego wszystkie
+  * współczynniki są stałymi, przechowywany jest jako liść (LEAF)
   */
 enum UnionTest {
     SIMPLE, /**< wielomian stały */
-    COMPLEX /**< wielomian normalny */
+    COMPLEX, /**< wielomian normalny, jednomiany w osobnych węzłach listy */
+    ARRAY, /**< wielomian normalny, jednomiany w jednym ciągłym bloku */
+    LEAF /**< wielomian o stałych współczynnikach, dwie tablice:
+          * współczynników i wykładników */
+};
+
+/** Wartość wielomianu: wskaźnik na jednomiany, liść albo stała */
+union PolyValue {
+    struct Mono *m; /**< m : wskaźnik na listę monomianów w wielomianie */
+    struct PolyLeaf *l; /**< l : wskaźnik na liść (LEAF) */
+    poly_coeff_t c; /**< c : wartość wielomianu gdy jest stałą */
 };
 
 /**
  * Struktura przechowująca wielomian w postaci listy jednomianów
  * posortowanej rosnąco względem wykładnika.
+ * W reprezentacji tablicowej (ARRAY) jednomiany poziomu leżą obok siebie
+ * w jednym bloku pamięci, a pole next wskazuje na następny element tablicy,
+ * więc funkcje czytające wielomian przechodzą obie reprezentacje tak samo.
  */
 typedef struct Poly {
     enum UnionTest tag; /**< tag : wskazuje na typ wielomianu (stała/wielomian normalny) */
-    union {
-        struct Mono *m; /**< m : wskaźnik na listę monomianów w wielomianie */
-        poly_coeff_t c; /**< c : wartość wielomianu gdy jest stałą */
-    } type; /**< type : określa typ wartości reprezentowanej przez unię */
+    union PolyValue type; /**< type : określa typ wartości reprezentowanej przez unię */
 } Poly;
 
+/** Maska bitów pola link jednomianu przechowujących typ współczynnika */
+#define MONO_TAG_MASK ((uintptr_t) 3)
+
 /**
   * Struktura przechowująca jednomian
   * Jednomian ma postać `p * x^e`.
   * Będzie on traktowany jako wielomian nad kolejną zmienną (nie nad x).
+  * Typ współczynnika trzymany jest w dwóch najmłodszych bitach wskaźnika
+  * na następny jednomian, dzięki czemu jednomian zajmuje 24 bajty.
+  * Pola czytane są wyłącznie przez funkcje MonoGetPoly, MonoSetPoly,
+  * MonoNext i MonoSetNext.
   */
 typedef struct Mono {
-    struct Poly p; /**< p : współczynnik monomianu, może być wielomianem */
+    union PolyValue coeff; /**< coeff : wartość współczynnika monomianu */
+    /** link : wskaźnik na następny monomian, w najmłodszych bitach
+     * typ współczynnika (enum UnionTest) */
+    uintptr_t link;
     poly_exp_t exp; /**< exp : wykładnik monomianu */
-    struct Mono *next; /**< next : wskaźnik na następny monomian */
+    /** refs : liczba wielomianów współdzielących poziom, którego ten
+     * monomian jest pierwszym elementem; w pozostałych elementach równa 1;
+     * najstarszy bit oznacza poziom internowany (zob. PolyIntern) */
+    unsigned refs;
 } Mono;
 
+/**
+ * Zwraca współczynnik jednomianu.
+ * @param[in] m : jednomian
+ * @return współczynnik, nadal należący do jednomianu
+ */
+static inline Poly MonoGetPoly(const Mono *m)
+{
+    return (Poly) {.tag = (enum UnionTest) (m->link & MONO_TAG_MASK),
+                   .type = m->coeff};
+}
+
+/**
+ * Ustawia współczynnik jednomianu, przejmując go na własność.
+ * @param[in,out] m : jednomian
+ * @param[in] p : nowy współczynnik
+ */
+static inline void MonoSetPoly(Mono *m, Poly p)
+{
+    m->coeff = p.type;
+    m->link = (m->link & ~MONO_TAG_MASK) | (uintptr_t) p.tag;
+}
+
+/**
+ * Sprawdza, czy współczynnik jednomianu jest stałą.
+ * @param[in] m : jednomian
+ * @return czy współczynnik jest stałą?
+ */
+static inline bool MonoIsCoeff(const Mono *m)
+{
+    return (m->link & MONO_TAG_MASK) == SIMPLE;
+}
+
+/**
+ * Zwraca następny jednomian poziomu.
+ * @param[in] m : jednomian
+ * @return następny jednomian lub NULL
+ */
+static inline struct Mono *MonoNext(const Mono *m)
+{
+    return (struct Mono*) (m->link & ~MONO_TAG_MASK);
+}
+
+/**
+ * Ustawia następny jednomian poziomu.
+ * @param[in,out] m : jednomian
+ * @param[in] next : następny jednomian lub NULL
+ */
+static inline void MonoSetNext(Mono *m, struct Mono *next)
+{
+    m->link = (uintptr_t) next | (m->link & MONO_TAG_MASK);
+}
+
+/**
+ * Liczniki tablicy internowania wielomianów
+ */
+typedef struct PolyInternStats {
+    size_t lookups; /**< lookups : liczba wyszukań poziomu w tablicy */
+    size_t hits; /**< hits : liczba wyszukań zakończonych znalezieniem */
+    size_t levels; /**< levels : liczba poziomów w tablicy */
+    size_t bytes_saved; /**< bytes_saved : pamięć jednomianów zaoszczędzona
+                          * dzięki współdzieleniu poziomów */
+} PolyInternStats;
+
+/**
+ * Liczniki wartościowania liści w wielu punktach, zob. PolyEvalMany
+ */
+typedef struct PolyEvalStats {
+    size_t batch_calls; /**< batch_calls : liczba liści wartościowanych
+                          * schematem Hornera na blokach punktów */
+    size_t tree_calls; /**< tree_calls : liczba liści wartościowanych
+                         * drzewem podiloczynów */
+} PolyEvalStats;
+
+/**
+ * Pamięć zajmowana przez wielomian, zob. PolyMemStats
+ */
+typedef struct PolyMemInfo {
+    size_t nodes; /**< nodes : liczba jednomianów na wszystkich poziomach,
+                    * łącznie z jednomianami liści */
+    unsigned depth; /**< depth : liczba poziomów zagnieżdżenia,
+                      * 0 dla stałej */
+    size_t leaves; /**< leaves : liczba liści (LEAF) */
+    size_t bytes; /**< bytes : pamięć jednomianów i liści w bajtach */
+} PolyMemInfo;
+
+/**
+ * Progi wyboru algorytmu mnożenia, zob. PolyMulSetTuning
+ */
+typedef struct PolyMulTuning {
+    size_t karatsuba_cutoff; /**< karatsuba_cutoff : długość, poniżej
+                               * której Karatsuba przechodzi na mnożenie
+                               * szkolne */
+    size_t karatsuba_density; /**< karatsuba_density : ile razy rozpiętość
+                                * wykładników czynnika może przekraczać
+                                * liczbę jego jednomianów, żeby stosować
+                                * Karatsubę */
+    size_t ntt_threshold; /**< ntt_threshold : długość krótszego czynnika,
+                            * od której stosowana jest transformata
+                            * teorioliczbowa z jedną liczbą pierwszą */
+    size_t ntt_prime_factor; /**< ntt_prime_factor : ile razy rośnie próg
+                               * ntt_threshold z każdą kolejną liczbą
+                               * pierwszą */
+    size_t kronecker_min_products; /**< kronecker_min_products : najmniejsza
+                                     * liczba iloczynów jednomianów, od
+                                     * której stosowane jest podstawienie
+                                     * Kroneckera */
+    size_t kronecker_max_span; /**< kronecker_max_span : największa długość
+                                 * tablicy współczynników iloczynu po
+                                 * podstawieniu Kroneckera */
+    size_t kronecker_sparsity; /**< kronecker_sparsity : ile razy tablica
+                                 * współczynników może być dłuższa od
+                                 * liczby iloczynów jednomianów */
+    size_t multipoint_threshold; /**< multipoint_threshold : najmniejsza
+                                   * liczba punktów i długość gęstego
+                                   * liścia, od których PolyAtMany
+                                   * wartościuje przez drzewo
+                                   * podiloczynów */
+} PolyMulTuning;
+
+/** Liczba kubełków akumulatora PolyBucket */
+#define POLY_BUCKETS 16
+
+/**
+ * Akumulator sumy wielu wielomianów (geobucket). Kubełek o numerze i
+ * przechowuje sumę o najwyżej `4^(i + 1)` jednomianach na najwyższym
+ * poziomie; gdy się przepełni, jest przelewany do następnego. Każdy
+ * jednomian przechodzi więc przez logarytmicznie wiele scaleń, zamiast
+ * być kopiowanym przy każdym dodaniu do rosnącej sumy.
+ */
+typedef struct PolyBucket {
+    Poly buckets[POLY_BUCKETS]; /**< buckets : sumy częściowe */
+    size_t sizes[POLY_BUCKETS]; /**< sizes : liczby jednomianów najwyższego
+                                  * poziomu sum częściowych */
+    poly_coeff_t constant; /**< constant : suma dodanych stałych */
+} PolyBucket;
+
+/**
+ * Skompilowany plan wartościowania wielomianu, zob. PolyCompileEval.
+ * Program to ciągła tablica słów: rozkaz, po którym następują jego
+ * argumenty. Ciągi jednomianów o stałych współczynnikach zapisane są
+ * jako pary (różnica wykładników, współczynnik), a współczynniki
+ * niebędące stałymi jako zagnieżdżone podprogramy.
+ */
+typedef struct PolyEvalPlan {
+    poly_coeff_t *code; /**< code : program, NULL dla programu pustego */
+    size_t length; /**< length : liczba słów programu */
+    unsigned depth; /**< depth : liczba zagnieżdżonych poziomów, 0 dla
+                      * stałej, 1 dla wielomianu jednej zmiennej */
+    unsigned powers; /**< powers : liczba potęg każdej zmiennej liczonych
+                       * przed wykonaniem programu, co najmniej 2 */
+} PolyEvalPlan;
+
 /*!
  * Tworzy wielomian, który jest współczynnikiem.
  * @param[in] c : wartość współczynnika
@@ -80,7 +258,7 @@ static inline Poly PolyZero()
  */
 static inline Mono MonoFromPoly(const Poly *p, poly_exp_t e)
 {
-    return (Mono) {.exp = e, .p = *p, .next = NULL};
+    return (Mono) {.coeff = p->type, .link = (uintptr_t) p->tag, .exp = e};
 }
 
 /**
@@ -100,39 +278,103 @@ static inline bool PolyIsCoeff(const Poly *p)
 static inline bool PolyIsZero(const Poly *p)
 {
     return ((p->tag == SIMPLE) && (p->type.c == 0)) ||
-           ((p->tag == COMPLEX) && (p->type.m == NULL));
+           ((p->tag != SIMPLE) && (p->type.m == NULL));
 }
 /**
- * Usuwa wielomian z pamięci.
+ * Usuwa wielomian z pamięci. Poziomy współdzielone z innymi wielomianami
+ * tracą jedną referencję i są usuwane razem z ostatnią z nich.
  * @param[in] p : wielomian
  */
 void PolyDestroy(Poly *p);
 
+/**
+ * Włącza odroczone zwalnianie pamięci: PolyDestroy zwalnia tylko
+ * referencję do korzenia, a usuwaniem poziomów zajmuje się wątek tła.
+ * Kolejka poziomów do usunięcia ma pojemność @p capacity; gdy jest pełna,
+ * PolyDestroy czeka na zwolnienie miejsca.
+ * Wielomiany nadal mogą być używane tylko przez jeden wątek.
+ * @param[in] capacity : pojemność kolejki, większa od zera
+ * @return czy odroczone zwalnianie jest włączone?
+ */
+bool PolyReclaimStart(size_t capacity);
+
+/**
+ * Czeka, aż wątek tła usunie wszystkie poziomy przekazane do tej pory.
+ */
+void PolyReclaimDrain(void);
+
+/**
+ * Opróżnia kolejkę, kończy wątek tła i przywraca synchroniczne PolyDestroy.
+ */
+void PolyReclaimStop(void);
+
 /**
  * Usuwa jednomian z pamięci.
  * @param[in] m : jednomian
  */
 static inline void MonoDestroy(Mono *m)
 {
-    PolyDestroy(&m->p);
+    Poly p = MonoGetPoly(m);
+    PolyDestroy(&p);
 }
 
 /**
- * Robi pełną, głęboką kopię wielomianu.
+ * Robi kopię wielomianu w czasie stałym.
+ * Poziomy wielomianu są współdzielone z oryginałem i zliczane referencjami,
+ * a współdzielony poziom jest kopiowany dopiero wtedy, gdy któraś z funkcji
+ * chce go zmodyfikować (kopiowanie przy zapisie).
  * @param[in] p : wielomian
  * @return skopiowany wielomian
  */
 Poly PolyClone(const Poly *p);
 
+/**
+ * Zamienia reprezentację wielomianu na tablicową (ARRAY) na wszystkich
+ * poziomach. Jednomiany każdego poziomu trafiają do jednego bloku pamięci
+ * o dokładnie potrzebnym rozmiarze.
+ * @param[in,out] p : wielomian
+ */
+void PolyPack(Poly *p);
+
+/**
+ * Internuje wielomian: każdy jego poziom zastępowany jest jedynym
+ * egzemplarzem strukturalnie równego poziomu z tablicy internowania
+ * (hash-consing). Poziomy internowane są w reprezentacji tablicowej
+ * i tylko do odczytu, więc równe wielomiany internowane mają ten sam
+ * wskaźnik i PolyIsEq porównuje je w czasie stałym.
+ * @param[in,out] p : wielomian
+ */
+void PolyIntern(Poly *p);
+
+/**
+ * Włącza lub wyłącza automatyczne internowanie wyników PolyAdd,
+ * PolyAddMonos i funkcji z nich korzystających (PolyMul, PolyCompose).
+ * @param[in] enabled : czy internować wyniki?
+ */
+void PolyInternEnable(bool enabled);
 
 /**
- * Robi pełną, głęboką kopię jednomianu.
+ * Oddaje referencje tablicy internowania i zwalnia tablicę. Poziomy nadal
+ * używane przez wielomiany pozostają w pamięci jako zwykłe poziomy.
+ */
+void PolyInternClear(void);
+
+/**
+ * Zwraca liczniki tablicy internowania.
+ * @return liczniki
+ */
+PolyInternStats PolyInternGetStats(void);
+
+/**
+ * Robi kopię jednomianu, współczynnik jest współdzielony jak w PolyClone.
  * @param[in] m : jednomian
  * @return skopiowany jednomian
  */
 static inline Mono MonoClone(const Mono *m)
 {
-    return (Mono) {.exp = m->exp, .p = PolyClone(&m->p)};
+    Poly p = MonoGetPoly(m);
+    Poly cloned = PolyClone(&p);
+    return MonoFromPoly(&cloned, m->exp);
 }
 
 /**
@@ -146,6 +388,7 @@ Poly PolyAdd(const Poly *p, const Poly *q);
 /**
  * Sumuje listę jednomianów i tworzy z nich wielomian.
  * Przejmuje na własność zawartość tablicy @p monos.
+ * Jednomiany wyniku umieszczane są w tablicy o dokładnym rozmiarze.
  * @param[in] count : liczba jednomianów
  * @param[in] monos : tablica jednomianów
  * @return wielomian będący sumą jednomianów
@@ -160,6 +403,84 @@ Poly PolyAddMonos(unsigned count, const Mono monos[]);
  */
 Poly PolyMul(const Poly *p, const Poly *q);
 
+/**
+ * Podnosi wielomian do kwadratu. Każdy iloczyn dwóch różnych jednomianów
+ * liczony jest raz i podwajany, więc działa około dwa razy szybciej niż
+ * `PolyMul(p, p)`.
+ * @param[in] p : wielomian
+ * @return `p * p`
+ */
+Poly PolySqr(const Poly *p);
+
+/**
+ * Mnoży wielomian przez stałą, mnożąc bezpośrednio współczynniki liści
+ * i stałe współczynniki na wszystkich poziomach.
+ * @param[in] p : wielomian
+ * @param[in] c : stała
+ * @return `p * c`
+ */
+Poly PolyMulScalar(const Poly *p, poly_coeff_t c);
+
+/**
+ * Mnoży wielomian przez stałą w miejscu. Poziomy, których wielomian jest
+ * jedynym właścicielem, są zmieniane bez przydzielania pamięci, pozostałe
+ * są zastępowane przez PolyMulScalar.
+ * @param[in,out] p : wielomian, zastępowany przez `p * c`
+ * @param[in] c : stała
+ */
+void PolyMulScalarInPlace(Poly *p, poly_coeff_t c);
+
+/**
+ * Dodaje stałą do wielomianu. Zmieniany jest tylko ciąg współczynników
+ * przy zerowych wykładnikach, pozostałe współczynniki są współdzielone
+ * z @p p.
+ * @param[in] p : wielomian
+ * @param[in] c : stała
+ * @return `p + c`
+ */
+Poly PolyAddScalar(const Poly *p, poly_coeff_t c);
+
+/**
+ * Dodaje stałą do wielomianu w miejscu. Poziomy, których wielomian jest
+ * jedynym właścicielem, są zmieniane bez kopiowania, pozostałe są
+ * zastępowane przez PolyAddScalar.
+ * @param[in,out] p : wielomian, zastępowany przez `p + c`
+ * @param[in] c : stała
+ */
+void PolyAddScalarInPlace(Poly *p, poly_coeff_t c);
+
+/**
+ * Zwraca bieżące progi wyboru algorytmu mnożenia.
+ * @return progi używane przez PolyMul
+ */
+PolyMulTuning PolyMulGetTuning(void);
+
+/**
+ * Ustawia progi wyboru algorytmu mnożenia. Progi wpływają tylko na szybkość
+ * PolyMul i PolyAtMany, nigdy na wynik. Zerowe pola zastępowane są
+ * wartościami domyślnymi.
+ * @param[in] tuning : nowe progi
+ */
+void PolyMulSetTuning(const PolyMulTuning *tuning);
+
+/**
+ * Wczytuje progi wyboru algorytmu mnożenia z pliku zapisanego przez
+ * PolyMulSaveTuning. Każdy wiersz pliku ma postać `nazwa wartość`, gdzie
+ * nazwa jest nazwą pola PolyMulTuning; nieznane nazwy i błędne wiersze
+ * są pomijane. Pola, których nie ma w pliku albo które są zerowe,
+ * dostają wartości domyślne.
+ * @param[in] path : ścieżka pliku
+ * @return czy udało się otworzyć plik?
+ */
+bool PolyMulLoadTuning(const char *path);
+
+/**
+ * Zapisuje bieżące progi wyboru algorytmu mnożenia do pliku.
+ * @param[in] path : ścieżka pliku
+ * @return czy udało się zapisać plik?
+ */
+bool PolyMulSaveTuning(const char *path);
+
 /**
  * Zwraca przeciwny wielomian.
  * @param[in] p : wielomian
@@ -175,6 +496,71 @@ Poly PolyNeg(const Poly *p);
  */
 Poly PolySub(const Poly *p, const Poly *q);
 
+/**
+ * Odejmuje wielomian od wielomianu w miejscu. Jednomiany @p p, których
+ * nie współdzielą inne wielomiany, są zmieniane bez kopiowania, a @p q
+ * jest negowany w trakcie scalania. @p q może być tym samym wielomianem
+ * co @p p albo jego klonem, ale nie jego współczynnikiem.
+ * @param[in,out] p : wielomian, zastępowany przez `p - q`
+ * @param[in] q : wielomian
+ */
+void PolySubInPlace(Poly *p, const Poly *q);
+
+/**
+ * Dodaje dwa wielomiany, przejmując je na własność. Jednomiany
+ * i współczynniki argumentów, których nie współdzielą inne wielomiany,
+ * są wykorzystywane w wyniku zamiast kopiowania.
+ * @param[in,out] p : wielomian, po wywołaniu równy zeru
+ * @param[in,out] q : wielomian, po wywołaniu równy zeru
+ * @return `p + q`
+ */
+Poly PolyAddOwned(Poly *p, Poly *q);
+
+/**
+ * Odejmuje wielomiany, przejmując je na własność. Wynik powstaje
+ * w miejscu @p p przez PolySubInPlace, więc @p q nie jest kopiowany ani
+ * negowany przed scaleniem.
+ * @param[in,out] p : wielomian, po wywołaniu równy zeru
+ * @param[in,out] q : wielomian, po wywołaniu równy zeru
+ * @return `p - q`
+ */
+Poly PolySubOwned(Poly *p, Poly *q);
+
+/**
+ * Mnoży wielomiany, przejmując je na własność. Gdy jeden z nich jest
+ * stałą, drugi mnożony jest w miejscu przez PolyMulScalarInPlace.
+ * @param[in,out] p : wielomian, po wywołaniu równy zeru
+ * @param[in,out] q : wielomian, po wywołaniu równy zeru
+ * @return `p * q`
+ */
+Poly PolyMulOwned(Poly *p, Poly *q);
+
+/**
+ * Zamienia wielomian na przeciwny w miejscu, zob. PolyMulScalarInPlace.
+ * @param[in,out] p : wielomian, zastępowany przez `-p`
+ */
+void PolyNegInPlace(Poly *p);
+
+/**
+ * Przygotowuje pusty akumulator sumy.
+ * @param[out] b : akumulator
+ */
+void PolyBucketInit(PolyBucket *b);
+
+/**
+ * Dodaje wielomian do akumulatora, przejmując go na własność.
+ * @param[in,out] b : akumulator
+ * @param[in,out] p : wielomian, po wywołaniu równy zeru
+ */
+void PolyBucketAdd(PolyBucket *b, Poly *p);
+
+/**
+ * Zwraca sumę wielomianów dodanych do akumulatora i opróżnia go.
+ * @param[in,out] b : akumulator, po wywołaniu pusty
+ * @return suma dodanych wielomianów
+ */
+Poly PolyBucketSum(PolyBucket *b);
+
 /**
  * Zwraca stopień wielomianu ze względu na zadaną zmienną (-1 dla wielomianu
  * tożsamościowo równego zeru).
@@ -195,6 +581,26 @@ poly_exp_t PolyDegBy(const Poly *p, unsigned var_idx);
  */
 poly_exp_t PolyDeg(const Poly *p);
 
+/**
+ * Zlicza pamięć zajmowaną przez wielomian.
+ * Poziom współdzielony przez kilka współczynników (zob. PolyClone
+ * i PolyIntern) liczony jest raz, a rozmiar w bajtach to rozmiar bloków
+ * przydzielonych z puli pamięci.
+ * @param[in] p : wielomian
+ * @return liczba jednomianów, głębokość, liczba liści i rozmiar w bajtach
+ */
+PolyMemInfo PolyMemStats(const Poly *p);
+
+/**
+ * Zlicza pamięć zajmowaną łącznie przez kilka wielomianów, jak
+ * PolyMemStats. Poziom współdzielony przez kilka wielomianów liczony jest
+ * raz, a głębokość to największa z głębokości wielomianów.
+ * @param[in] count : liczba wielomianów
+ * @param[in] polys : tablica wielomianów
+ * @return liczba jednomianów, głębokość, liczba liści i rozmiar w bajtach
+ */
+PolyMemInfo PolyMemStatsMany(size_t count, const Poly polys[]);
+
 /**
  * Sprawdza równość dwóch wielomianów.
  * @param[in] p : wielomian
@@ -216,6 +622,100 @@ bool PolyIsEq(const Poly *p, const Poly *q);
  */
 Poly PolyAt(const Poly *p, poly_coeff_t x);
 
+/**
+ * Wylicza wartość wielomianu w punkcie, nie tworząc pośrednich wielomianów
+ * i nie alokując pamięci. Pod zmienną @f$x_i@f$ podstawiana jest wartość
+ * `xs[i]` dla @f$i < n@f$, a pod pozostałe zmienne zero.
+ * @param[in] p : wielomian
+ * @param[in] n : liczba wartości w tablicy @p xs
+ * @param[in] xs : wartości kolejnych zmiennych
+ * @return @f$p(xs_0, xs_1, \ldots, xs_{n-1}, 0, 0, \ldots)@f$
+ */
+poly_coeff_t PolyEval(const Poly *p, unsigned n, const poly_coeff_t xs[]);
+
+/**
+ * Wylicza wartości wielomianu, którego współczynniki są stałymi, w @p k
+ * punktach naraz, zob. PolyAt. Punkty liczone są blokami na rejestrach
+ * wektorowych, a lista jednomianów przechodzona jest raz na blok. Gdy
+ * liczba punktów i stopień gęstego wielomianu przekraczają próg
+ * multipoint_threshold (zob. PolyMulSetTuning), wartości liczone są
+ * przez PolyAtManyTree.
+ * @param[in] p : wielomian
+ * @param[in] k : liczba punktów
+ * @param[in] xs : punkty
+ * @param[out] out : wartości w punktach, tablica długości @p k
+ * @return czy wszystkie współczynniki @p p są stałymi? W przeciwnym razie
+ * @p out pozostaje bez zmian.
+ */
+bool PolyAtMany(const Poly *p, size_t k, const poly_coeff_t xs[],
+                poly_coeff_t out[]);
+
+/**
+ * Wylicza wartości wielomianu, którego współczynniki są stałymi, w @p k
+ * punktach drzewem podiloczynów: iloczyny `(x - xs[j])` dla coraz
+ * większych grup punktów dają drzewo, a reszty wielomianu modulo węzły
+ * drzewa liczone są od korzenia w dół. Dla wielomianu stopnia n w n
+ * punktach wymaga `O(M(n) log n)` działań, gdzie M(n) to koszt mnożenia,
+ * zamiast `O(n^2)`. Węzły drzewa są wielomianami unormowanymi, więc wyniki
+ * są identyczne z PolyAt przy arytmetyce modulo 2^64. Pamięć zależy od
+ * stopnia wielomianu, a nie od liczby jego jednomianów.
+ * @param[in] p : wielomian
+ * @param[in] k : liczba punktów
+ * @param[in] xs : punkty
+ * @param[out] out : wartości w punktach, tablica długości @p k
+ * @return czy wszystkie współczynniki @p p są stałymi? W przeciwnym razie
+ * @p out pozostaje bez zmian.
+ */
+bool PolyAtManyTree(const Poly *p, size_t k, const poly_coeff_t xs[],
+                    poly_coeff_t out[]);
+
+/**
+ * Wylicza wartości wielomianu w @p k punktach naraz, zob. PolyEval.
+ * Wartości zmiennych podane są kolejno dla każdej zmiennej: `xs[i * k + j]`
+ * to wartość zmiennej @f$x_i@f$ w punkcie o numerze j. Pod zmienne
+ * o indeksach od @p n podstawiane jest zero.
+ * @param[in] p : wielomian
+ * @param[in] n : liczba zmiennych o podanych wartościach
+ * @param[in] k : liczba punktów
+ * @param[in] xs : wartości zmiennych, tablica długości `n * k`
+ * @param[out] out : wartości w punktach, tablica długości @p k
+ */
+void PolyEvalMany(const Poly *p, unsigned n, size_t k,
+                  const poly_coeff_t xs[], poly_coeff_t out[]);
+
+/**
+ * Zwraca liczniki wartościowania w wielu punktach; pozwalają sprawdzić,
+ * którą metodę wybrał próg multipoint_threshold.
+ * @return liczniki
+ */
+PolyEvalStats PolyEvalGetStats(void);
+
+/**
+ * Kompiluje wielomian do planu wartościowania: zagnieżdżone listy
+ * jednomianów spłaszczane są do jednego programu schematu Hornera, więc
+ * kolejne wartościowania przechodzą ciągłą tablicę zamiast wskaźników.
+ * Plan nie zależy od @p p i pozostaje ważny po jego usunięciu.
+ * @param[in] p : wielomian
+ * @return plan, do zwolnienia funkcją PolyEvalPlanDestroy
+ */
+PolyEvalPlan PolyCompileEval(const Poly *p);
+
+/**
+ * Wykonuje plan wartościowania, zob. PolyEval.
+ * @param[in] plan : plan utworzony przez PolyCompileEval
+ * @param[in] n : liczba wartości w tablicy @p xs
+ * @param[in] xs : wartości kolejnych zmiennych
+ * @return wartość wielomianu, identyczna z PolyEval
+ */
+poly_coeff_t PolyEvalCompiled(const PolyEvalPlan *plan, unsigned n,
+                              const poly_coeff_t xs[]);
+
+/**
+ * Zwalnia pamięć planu wartościowania.
+ * @param[in] plan : plan
+ */
+void PolyEvalPlanDestroy(PolyEvalPlan *plan);
+
 /**
  * Funkcja wypisująca wielomian w postaci
  * (WSPÓŁCZYNNIK, WYKŁADNIK)+(WSPÓŁCZYNNIK, WYKŁADNIK)+...
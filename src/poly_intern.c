@@ -0,0 +1,312 @@
+/** @file
+   Internowanie wielomianów: tablica z adresowaniem otwartym, w której
+   równe poziomy są przechowywane jeden raz i współdzielone
+
+   @author Piotr Szuberski <p.szuberski@student.uw.edu.pl>,
+   @copyright Uniwersytet Warszawski
+   @date 2026-10-18,
+*/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "utils.h"
+#include "poly_internal.h"
+
+/** Początkowa pojemność tablicy internowania */
+#define INTERN_START 1024
+
+/**
+ * Element tablicy internowania
+ */
+typedef struct InternSlot {
+    Poly level; /**< level : internowany poziom, zero oznacza wolne miejsce */
+    uint64_t hash; /**< hash : skrót strukturalny poziomu */
+} InternSlot;
+
+/**
+ * Tablica internowania z adresowaniem otwartym. Trzyma po jednej referencji
+ * do każdego internowanego poziomu.
+ */
+static struct {
+    InternSlot *slots; /**< slots : tablica elementów */
+    size_t capacity; /**< capacity : pojemność, potęga dwójki */
+    size_t size; /**< size : liczba zajętych elementów */
+    bool enabled; /**< enabled : czy wyniki są internowane automatycznie */
+    PolyInternStats stats; /**< stats : liczniki */
+} intern_table;
+
+/**
+ * Liczy skrót strukturalny poziomu, którego współczynniki są stałymi
+ * lub poziomami internowanymi.
+ * @param[in] p : wielomian w reprezentacji tablicowej lub liść
+ * @return skrót
+ */
+static uint64_t PolyLevelHash(const Poly *p)
+{
+    uint64_t hash = 0xcbf29ce484222325u, value;
+    const Mono *head;
+    const PolyLeaf *leaf;
+
+    if (p->tag == LEAF) {
+        leaf = p->type.l;
+        for (unsigned i = 0; i < leaf->count; i++) {
+            hash = (hash ^ (uint64_t) (uint32_t) LeafExps(leaf)[i]) *
+                   0x100000001b3u;
+            hash = (hash ^ (uint64_t) leaf->coeffs[i]) * 0x9e3779b97f4a7c15u;
+            hash ^= hash >> 29;
+        }
+        return hash;
+    }
+    for (head = p->type.m; head != NULL; head = MonoNext(head)) {
+        if (MonoIsCoeff(head)) {
+            value = (uint64_t) head->coeff.c;
+        }
+        else {
+            value = (uint64_t) (uintptr_t) head->coeff.m;
+        }
+        hash = (hash ^ (uint64_t) (uint32_t) head->exp) * 0x100000001b3u;
+        hash = (hash ^ value) * 0x9e3779b97f4a7c15u;
+        hash ^= hash >> 29;
+    }
+    return hash;
+}
+
+/**
+ * Sprawdza, czy dwa poziomy są równe, zakładając, że współczynniki
+ * niebędące stałymi są internowane.
+ * @param[in] p : wielomian w reprezentacji tablicowej lub liść
+ * @param[in] q : wielomian w reprezentacji tablicowej lub liść
+ * @return czy poziomy są równe?
+ */
+static bool PolyLevelEq(const Poly *p, const Poly *q)
+{
+    const Mono *a, *b;
+
+    if (p->tag != q->tag) {
+        return false;
+    }
+    if (p->tag == LEAF) {
+        return p->type.l->count == q->type.l->count &&
+               memcmp(p->type.l->coeffs, q->type.l->coeffs,
+                      LeafSize(p->type.l->count) - sizeof(PolyLeaf)) == 0;
+    }
+    a = p->type.m;
+    b = q->type.m;
+    while (a != NULL && b != NULL) {
+        if (a->exp != b->exp || MonoIsCoeff(a) != MonoIsCoeff(b)) {
+            return false;
+        }
+        if (MonoIsCoeff(a) ? a->coeff.c != b->coeff.c
+                           : a->coeff.m != b->coeff.m) {
+            return false;
+        }
+        a = MonoNext(a);
+        b = MonoNext(b);
+    }
+    return a == NULL && b == NULL;
+}
+
+/**
+ * Umieszcza poziom w tablicy internowania, bez sprawdzania duplikatów.
+ * @param[in] level : internowany poziom
+ * @param[in] hash : skrót poziomu
+ */
+static void InternInsert(Poly level, uint64_t hash)
+{
+    size_t i = (size_t) hash & (intern_table.capacity - 1);
+
+    while (!PolyIsZero(&intern_table.slots[i].level)) {
+        i = (i + 1) & (intern_table.capacity - 1);
+    }
+    intern_table.slots[i].level = level;
+    intern_table.slots[i].hash = hash;
+    intern_table.size++;
+}
+
+/**
+ * Szuka w tablicy internowania miejsca zajmowanego przez poziom.
+ * Pomija miejsca zwolnione przez InternGrow, które mają niezerowy skrót.
+ * @param[in] level : internowany poziom
+ * @return indeks miejsca lub pojemność tablicy, gdy poziomu w niej nie ma
+ */
+static size_t InternFind(const Poly *level)
+{
+    size_t i = (size_t) PolyLevelHash(level) & (intern_table.capacity - 1);
+    const Poly *slot;
+
+    for (;;) {
+        slot = &intern_table.slots[i].level;
+        if (PolyIsZero(slot) && intern_table.slots[i].hash == 0) {
+            return intern_table.capacity;
+        }
+        if (slot->tag == level->tag &&
+            (level->tag == LEAF ? slot->type.l == level->type.l
+                                : slot->type.m == level->type.m)) {
+            return i;
+        }
+        i = (i + 1) & (intern_table.capacity - 1);
+    }
+}
+
+/**
+ * Powiększa tablicę internowania, usuwając z niej najpierw poziomy,
+ * do których nie ma już referencji spoza tablicy.
+ */
+static void InternGrow(void)
+{
+    InternSlot *old = intern_table.slots;
+    size_t old_capacity = intern_table.capacity, i;
+    WorkStack released, children;
+    Poly level, child;
+    Mono *m;
+
+    /* Usunięcie poziomu może zostawić jego współczynniki tylko w tablicy,
+     * więc sprawdzane są od razu, zamiast ponownie przeglądać całą tablicę.
+     * Zwolnione miejsca dostają niezerowy skrót, żeby InternFind
+     * przechodził przez nie do dalszych miejsc. */
+    WorkStackInit(&released, sizeof(size_t));
+    WorkStackInit(&children, sizeof(Poly));
+    for (i = 0; i < old_capacity; i++) {
+        WorkStackPush(&released, &i);
+    }
+    while (WorkStackPop(&released, &i)) {
+        level = old[i].level;
+        if (PolyIsZero(&level) ||
+            (*PolyRefs(&level) & ~MONO_INTERNED) != 1) {
+            continue;
+        }
+        __atomic_and_fetch(PolyRefs(&level), ~MONO_INTERNED,
+                           __ATOMIC_RELAXED);
+        old[i].level = PolyZero();
+        old[i].hash |= 1;
+        intern_table.size--;
+        if (level.tag != LEAF) {
+            for (m = level.type.m; m != NULL; m = MonoNext(m)) {
+                child = MonoGetPoly(m);
+                if (!PolyIsCoeff(&child)) {
+                    WorkStackPush(&children, &child);
+                }
+            }
+        }
+        PolyDestroy(&level);
+        while (WorkStackPop(&children, &child)) {
+            if ((*PolyRefs(&child) & ~MONO_INTERNED) == 1) {
+                i = InternFind(&child);
+                if (i < old_capacity) {
+                    WorkStackPush(&released, &i);
+                }
+            }
+        }
+    }
+    WorkStackFree(&children);
+    WorkStackFree(&released);
+    if (intern_table.size * 4 >= old_capacity) {
+        intern_table.capacity = old_capacity == 0 ? INTERN_START
+                                                  : 2 * old_capacity;
+    }
+    intern_table.slots = (InternSlot*) calloc(intern_table.capacity,
+                                              sizeof(InternSlot));
+    assert(intern_table.slots != NULL);
+    intern_table.size = 0;
+    for (i = 0; i < old_capacity; i++) {
+        if (!PolyIsZero(&old[i].level)) {
+            InternInsert(old[i].level, old[i].hash);
+        }
+    }
+    intern_table.stats.levels = intern_table.size;
+    free(old);
+}
+
+Poly PolyInterned(Poly p)
+{
+    if (intern_table.enabled) {
+        PolyIntern(&p);
+    }
+    return p;
+}
+
+void PolyIntern(Poly *p)
+{
+    Mono *m;
+    Poly coeff, leaf;
+    uint64_t hash;
+    size_t i, count;
+
+    if (PolyIsZero(p) || PolyIsCoeff(p) || PolyIsInterned(p)) {
+        return;
+    }
+    PolyUnshare(p);
+    if (p->tag != LEAF) {
+        for (m = p->type.m; m != NULL; m = MonoNext(m)) {
+            coeff = MonoGetPoly(m);
+            PolyIntern(&coeff);
+            MonoSetPoly(m, coeff);
+        }
+        if (p->tag == COMPLEX) {
+            *p = PolyPackList(p->type.m);
+        }
+        else if (MonoAllCoeffs(p->type.m)) {
+            leaf = LeafFromMonos(p->type.m);
+            PolyDestroy(p);
+            *p = leaf;
+        }
+    }
+    if (2 * (intern_table.size + 1) > intern_table.capacity) {
+        InternGrow();
+    }
+    hash = PolyLevelHash(p);
+    intern_table.stats.lookups++;
+    i = (size_t) hash & (intern_table.capacity - 1);
+    while (!PolyIsZero(&intern_table.slots[i].level)) {
+        if (intern_table.slots[i].hash == hash &&
+            PolyLevelEq(&intern_table.slots[i].level, p)) {
+            if (p->tag == LEAF) {
+                count = LeafSize(p->type.l->count);
+            }
+            else {
+                count = (size_t) MonoCountBlocks(p->type.m) * sizeof(Mono);
+            }
+            intern_table.stats.hits++;
+            intern_table.stats.bytes_saved += count;
+            PolyDestroy(p);
+            *p = PolyClone(&intern_table.slots[i].level);
+            return;
+        }
+        i = (i + 1) & (intern_table.capacity - 1);
+    }
+    *PolyRefs(p) = (*PolyRefs(p) + 1) | MONO_INTERNED;
+    InternInsert(*p, hash);
+    intern_table.stats.levels = intern_table.size;
+}
+
+void PolyInternEnable(bool enabled)
+{
+    intern_table.enabled = enabled;
+}
+
+void PolyInternClear(void)
+{
+    Poly level;
+
+    for (size_t i = 0; i < intern_table.capacity; i++) {
+        level = intern_table.slots[i].level;
+        if (!PolyIsZero(&level)) {
+            __atomic_and_fetch(PolyRefs(&level), ~MONO_INTERNED,
+                               __ATOMIC_RELAXED);
+        }
+    }
+    for (size_t i = 0; i < intern_table.capacity; i++) {
+        PolyDestroy(&intern_table.slots[i].level);
+    }
+    free(intern_table.slots);
+    intern_table.slots = NULL;
+    intern_table.capacity = 0;
+    intern_table.size = 0;
+    intern_table.stats.levels = 0;
+}
+
+PolyInternStats PolyInternGetStats(void)
+{
+    return intern_table.stats;
+}
@@ -0,0 +1,405 @@
+/** @file
+   Wewnętrzny interfejs implementacji wielomianów
+
+   Deklaracje współdzielone przez poly.c i pliki z wydzielonymi częściami
+   implementacji: liśćmi (poly_leaf.c), mnożeniem (poly_mul.c), progami
+   wyboru algorytmu mnożenia (poly_tuning.c), internowaniem (poly_intern.c)
+   i odroczonym zwalnianiem (poly_reclaim.c). Plik nie należy do interfejsu
+   biblioteki i nie jest dołączany przez kalkulator.
+
+   @author Piotr Szuberski <p.szuberski@student.uw.edu.pl>,
+   @copyright Uniwersytet Warszawski
+   @date 2026-10-18,
+*/
+
+#ifndef WIELOMIANY_POLY_INTERNAL_H
+#define WIELOMIANY_POLY_INTERNAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "mem_pool.h"
+#include "poly.h"
+
+/** Rozmiar bufora stosu roboczego trzymanego w ramce wywołania */
+#define WORK_STACK_LOCAL 1024
+
+/**
+ * Stos roboczy dla funkcji przechodzących wielomian bez rekurencji.
+ * Dopóki się mieści, używa bufora w ramce wywołania, potem sterty,
+ * więc głębokość wielomianu nie zależy od rozmiaru stosu wywołań.
+ */
+typedef struct WorkStack {
+    char *items; /**< items : elementy stosu */
+    size_t size; /**< size : liczba elementów */
+    size_t capacity; /**< capacity : pojemność w elementach */
+    size_t elem; /**< elem : rozmiar elementu w bajtach */
+    /** local : bufor początkowy */
+    _Alignas(max_align_t) char local[WORK_STACK_LOCAL];
+} WorkStack;
+
+/**
+ * Inicjalizuje pusty stos roboczy.
+ * @param[out] ws : stos
+ * @param[in] elem : rozmiar elementu, nie większy niż WORK_STACK_LOCAL
+ */
+void WorkStackInit(WorkStack *ws, size_t elem);
+
+/**
+ * Kładzie element na stos roboczy.
+ * @param[in,out] ws : stos
+ * @param[in] item : element
+ */
+void WorkStackPush(WorkStack *ws, const void *item);
+
+/**
+ * Zdejmuje element ze stosu roboczego.
+ * @param[in,out] ws : stos
+ * @param[out] item : zdjęty element
+ * @return czy stos był niepusty?
+ */
+bool WorkStackPop(WorkStack *ws, void *item);
+
+/**
+ * Zwalnia pamięć stosu roboczego.
+ * @param[in] ws : stos
+ */
+void WorkStackFree(WorkStack *ws);
+
+/**
+ * Dodaje współczynniki modulo 2^64. Suma liczona jest w unsigned long,
+ * więc przepełnienie nie jest niezdefiniowanym zachowaniem.
+ * @param[in] a : współczynnik
+ * @param[in] b : współczynnik
+ * @return `a + b` modulo 2^64
+ */
+static inline poly_coeff_t CoeffAdd(poly_coeff_t a, poly_coeff_t b)
+{
+    return (poly_coeff_t) ((unsigned long) a + (unsigned long) b);
+}
+
+/**
+ * Mnoży współczynniki modulo 2^64, zob. CoeffAdd.
+ * @param[in] a : współczynnik
+ * @param[in] b : współczynnik
+ * @return `a * b` modulo 2^64
+ */
+static inline poly_coeff_t CoeffMul(poly_coeff_t a, poly_coeff_t b)
+{
+    return (poly_coeff_t) ((unsigned long) a * (unsigned long) b);
+}
+
+/**
+ * Liść: poziom wielomianu, którego wszystkie współczynniki są stałymi.
+ * Za nagłówkiem leżą kolejno tablica współczynników i tablica wykładników
+ * (rosnąco), obie długości count, w jednym bloku pamięci.
+ */
+typedef struct PolyLeaf {
+    /** refs : liczba wielomianów współdzielących liść; najstarszy bit
+     * oznacza liść internowany */
+    unsigned refs;
+    unsigned count; /**< count : liczba jednomianów */
+    poly_coeff_t coeffs[]; /**< coeffs : współczynniki jednomianów */
+} PolyLeaf;
+
+/**
+ * Liczy rozmiar bloku pamięci liścia.
+ * @param[in] count : liczba jednomianów
+ * @return rozmiar w bajtach
+ */
+static inline size_t LeafSize(unsigned count)
+{
+    return sizeof(PolyLeaf) +
+           count * (sizeof(poly_coeff_t) + sizeof(poly_exp_t));
+}
+
+/**
+ * Zwraca tablicę wykładników liścia.
+ * @param[in] l : liść
+ * @return tablica wykładników
+ */
+static inline poly_exp_t *LeafExps(const PolyLeaf *l)
+{
+    return (poly_exp_t*) (l->coeffs + l->count);
+}
+
+/**
+ * Oddaje do puli pamięć liścia.
+ * @param[in] l : liść
+ */
+static inline void LeafFree(PolyLeaf *l)
+{
+    MemPoolFree(l, LeafSize(l->count));
+}
+
+/** Bit pola refs oznaczający poziom umieszczony w tablicy internowania */
+#define MONO_INTERNED (1u << 31)
+
+/**
+ * Zwraca licznik referencji najwyższego poziomu wielomianu.
+ * @param[in] p : wielomian niebędący stałą ani zerem
+ * @return wskaźnik na licznik referencji
+ */
+static inline unsigned *PolyRefs(const Poly *p)
+{
+    return p->tag == LEAF ? &p->type.l->refs : &p->type.m->refs;
+}
+
+/**
+ * Sprawdza, czy najwyższy poziom wielomianu jest internowany.
+ * @param[in] p : wielomian niebędący stałą ani zerem
+ * @return czy poziom jest w tablicy internowania?
+ */
+static inline bool PolyIsInterned(const Poly *p)
+{
+    return (*PolyRefs(p) & MONO_INTERNED) != 0;
+}
+
+/** Czy działa wątek tła odroczonego zwalniania, zob. PolyReclaimStart */
+extern bool reclaim_active;
+
+/**
+ * Zwiększa licznik referencji, atomowo, gdy działa wątek tła.
+ * @param[in,out] refs : licznik
+ */
+static inline void RefsAcquire(unsigned *refs)
+{
+    if (reclaim_active) {
+        __atomic_add_fetch(refs, 1, __ATOMIC_RELAXED);
+    }
+    else {
+        (*refs)++;
+    }
+}
+
+/**
+ * Zmniejsza licznik referencji, atomowo, gdy działa wątek tła.
+ * @param[in,out] refs : licznik
+ * @return nowa wartość licznika
+ */
+static inline unsigned RefsRelease(unsigned *refs)
+{
+    if (reclaim_active) {
+        return __atomic_sub_fetch(refs, 1, __ATOMIC_ACQ_REL);
+    }
+    return --*refs;
+}
+
+/**
+ * Zwalnia jedną referencję do poziomu wielomianu.
+ * @param[in] head : pierwszy jednomian poziomu
+ * @return czy była to ostatnia referencja i poziom trzeba usunąć?
+ */
+static inline bool MonoRelease(Mono *head)
+{
+    return head == NULL || RefsRelease(&head->refs) == 0;
+}
+
+/**
+ * Przydziela liść o @p count jednomianach, tablice muszą zostać uzupełnione
+ * przez wywołującego.
+ * @param[in] count : liczba jednomianów, większa od zera
+ * @return liść
+ */
+PolyLeaf *LeafNew(unsigned count);
+
+/**
+ * Tworzy wielomian z pierwszych @p count jednomianów liścia, skracając go
+ * do dokładnego rozmiaru. Zero lub sama stała zwracane są jako SIMPLE.
+ * @param[in] l : liść, przejmowany na własność
+ * @param[in] count : liczba wypełnionych jednomianów
+ * @return wielomian
+ */
+Poly LeafFinish(PolyLeaf *l, unsigned count);
+
+/**
+ * Sprawdza, czy wszystkie współczynniki listy jednomianów są stałymi.
+ * @param[in] m : lista jednomianów
+ * @return czy poziom może być liściem?
+ */
+bool MonoAllCoeffs(const Mono *m);
+
+/**
+ * Tworzy liść o tych samych jednomianach co lista @p m,
+ * której wszystkie współczynniki są stałymi. Lista zostaje bez zmian.
+ * @param[in] m : niepusta lista jednomianów
+ * @return wielomian w postaci liścia
+ */
+Poly LeafFromMonos(const Mono *m);
+
+/**
+ * Tworzy tymczasową reprezentację tablicową liścia dla funkcji,
+ * które nie mają osobnej ścieżki dla liści.
+ * @param[in] p : wielomian w postaci liścia
+ * @return wielomian w reprezentacji tablicowej
+ */
+Poly LeafExpand(const Poly *p);
+
+/**
+ * Dodaje stałą do liścia.
+ * @param[in] a : liść
+ * @param[in] c : stała
+ * @return `a + c`
+ */
+Poly LeafAddCoeff(const PolyLeaf *a, poly_coeff_t c);
+
+/**
+ * Mnoży liść przez stałą.
+ * @param[in] a : liść
+ * @param[in] c : stała
+ * @return `a * c`
+ */
+Poly LeafScale(const PolyLeaf *a, poly_coeff_t c);
+
+/**
+ * Zwraca liść przeciwny.
+ * @param[in] a : liść
+ * @return `-a`
+ */
+Poly LeafNeg(const PolyLeaf *a);
+
+/**
+ * Wylicza wartość liścia w punkcie @p x schematem Hornera, od
+ * najwyższego wykładnika, mnożąc przez potęgę @p x o różnicę kolejnych
+ * wykładników.
+ * @param[in] a : niepusty liść
+ * @param[in] x : punkt
+ * @return `a(x)`
+ */
+poly_coeff_t LeafAt(const PolyLeaf *a, poly_coeff_t x);
+
+/**
+ * Sprawdza równość liścia z wielomianem niebędącym stałą.
+ * @param[in] a : liść
+ * @param[in] q : wielomian normalny
+ * @return `a = q`
+ */
+bool LeafIsEq(const PolyLeaf *a, const Poly *q);
+
+/**
+ * Dodaje wielomiany, z których co najmniej jeden jest liściem,
+ * pomocnicza funkcja dla PolyAdd.
+ * @param[in] p : wielomian
+ * @param[in] q : wielomian
+ * @return `p + q`
+ */
+Poly PolyAddLeaf(const Poly *p, const Poly *q);
+
+/**
+ * Odejmuje wielomiany niebędące stałymi, z których co najmniej jeden jest
+ * liściem, pomocnicza funkcja dla PolySub.
+ * @param[in] p : wielomian
+ * @param[in] q : wielomian
+ * @return `p - q`
+ */
+Poly PolySubLeaf(const Poly *p, const Poly *q);
+
+/** Progi wyboru algorytmu mnożenia, zob. PolyMulSetTuning */
+extern PolyMulTuning mul_tuning;
+
+/**
+ * Sprawdza, czy wartościowanie liścia w @p k punktach opłaca się liczyć
+ * drzewem podiloczynów: liczba punktów i długość liścia muszą osiągać
+ * multipoint_threshold, a liść musi być gęsty w sensie karatsuba_density.
+ * @param[in] a : liść
+ * @param[in] k : liczba punktów
+ * @return czy stosować drzewo podiloczynów?
+ */
+bool MultipointPays(const PolyLeaf *a, size_t k);
+
+/**
+ * Wylicza wartości liścia w @p k punktach drzewem podiloczynów. Jak LeafAt
+ * liczy modulo 2^64, na unsigned long.
+ * @param[in] a : liść
+ * @param[in] k : liczba punktów
+ * @param[in] xs : punkty
+ * @param[out] out : wartości w punktach
+ */
+void LeafAtManyTree(const PolyLeaf *a, size_t k,
+                    const poly_coeff_t xs[], poly_coeff_t out[]);
+
+/**
+ * Przydziela tablicę @p count jednomianów połączonych polami next.
+ * Współczynniki i wykładniki muszą zostać uzupełnione przez wywołującego.
+ * @param[in] count : liczba jednomianów, większa od zera
+ * @return pierwszy element tablicy
+ */
+Mono *MonoArrayNew(unsigned count);
+
+/**
+ * Pomocnicza funkcja dla PolyMul, liczy liczbę bloków
+ * potrzebnych do zaalokowania w pamięci
+ * @param[in] m: lista monomianów
+ * @return liczba monomianów w liście
+ */
+poly_exp_t MonoCountBlocks(const Mono *m);
+
+/**
+ * Funkcja wykonująca algorytm binpower
+ * @param[in] x: podstawa potęgi
+ * @param[in] n: wykładnik potęgi
+ * @return 'x^n'
+ */
+poly_coeff_t PolyPower(poly_coeff_t x, poly_exp_t n);
+
+/**
+ * Tworzy wielomian z jednomianów posortowanych rosnąco względem wykładnika,
+ * o różnych wykładnikach i niezerowych współczynnikach. Jednomiany trafiają
+ * do tablicy o dokładnie potrzebnym rozmiarze.
+ * Przejmuje na własność współczynniki jednomianów.
+ * @param[in] count : liczba jednomianów
+ * @param[in] monos : tablica jednomianów
+ * @return utworzony wielomian
+ */
+Poly PolyFromMonoArray(unsigned count, const Mono monos[]);
+
+/**
+ * Funkcja dodająca wielomiany i usuwająca swoje argumenty,
+ * @param[in] p
+ * @param[in] q
+ * @return 'p + q'
+ */
+Poly PolyAddNoConsts(Poly *p, Poly *q);
+
+/**
+ * Internuje wielomian, jeśli włączone jest automatyczne internowanie.
+ * @param[in] p : wielomian
+ * @return wielomian po internowaniu
+ */
+Poly PolyInterned(Poly p);
+
+/**
+ * Przenosi jednomiany z listy do tablicy i zwalnia węzły listy.
+ * @param[in] m : lista jednomianów
+ * @return wielomian w reprezentacji tablicowej
+ */
+Poly PolyPackList(Mono *m);
+
+/**
+ * Zapewnia, że najwyższy poziom wielomianu nie jest współdzielony,
+ * kopiując go, gdy ma więcej niż jedną referencję (kopiowanie przy zapisie).
+ * Współczynniki kopii są współdzielone z oryginałem.
+ * @param[in,out] p : wielomian
+ */
+void PolyUnshare(Poly *p);
+
+/**
+ * Zwalnia poziomy wielomianu i jego współczynników, do których nie ma
+ * innych referencji.
+ * W wątku głównym zwalnia jedną referencję do każdego odwiedzanego poziomu.
+ * W wątku tła korzeń należy już wyłącznie do niego, współczynniki
+ * współdzielone z innymi wielomianami oddawane są wątkowi głównemu,
+ * a pamięć wraca do puli przez MemPoolFreeRemote.
+ * @param[in] level : wielomian niebędący stałą ani zerem
+ * @param[in] background : czy funkcja działa w wątku tła?
+ */
+void PolyFreeLevels(Poly level, bool background);
+
+/**
+ * Zwalnia referencję do poziomu w trybie odroczonym: ostatnia referencja
+ * powoduje włożenie poziomu do kolejki, czekając na miejsce, gdy kolejka
+ * jest pełna. Przy okazji zwalnia referencje oddane przez wątek tła.
+ * @param[in] level : wielomian niebędący stałą ani zerem
+ */
+void ReclaimRelease(Poly level);
+
+#endif //WIELOMIANY_POLY_INTERNAL_H
@@ -0,0 +1,246 @@
+/** @file
+   Liście: poziomy wielomianów o stałych współczynnikach, przechowywane
+   jako dwie tablice w jednym bloku pamięci
+
+   @author Piotr Szuberski <p.szuberski@student.uw.edu.pl>,
+   @copyright Uniwersytet Warszawski
+   @date 2026-10-18,
+*/
+
+#include <string.h>
+#include "utils.h"
+#include "poly_internal.h"
+
+PolyLeaf *LeafNew(unsigned count)
+{
+    PolyLeaf *l = (PolyLeaf*) MemPoolAlloc(LeafSize(count));
+
+    l->refs = 1;
+    l->count = count;
+    return l;
+}
+
+Poly LeafFinish(PolyLeaf *l, unsigned count)
+{
+    PolyLeaf *exact;
+    poly_coeff_t c;
+
+    if (count == 0) {
+        LeafFree(l);
+        return PolyZero();
+    }
+    else if (count == 1 && LeafExps(l)[0] == 0) {
+        c = l->coeffs[0];
+        LeafFree(l);
+        return PolyFromCoeff(c);
+    }
+    else if (count < l->count) {
+        exact = LeafNew(count);
+        memcpy(exact->coeffs, l->coeffs, count * sizeof(poly_coeff_t));
+        memcpy(LeafExps(exact), LeafExps(l), count * sizeof(poly_exp_t));
+        LeafFree(l);
+        l = exact;
+    }
+    return (Poly) {.tag = LEAF, .type.l = l};
+}
+
+bool MonoAllCoeffs(const Mono *m)
+{
+    while (m != NULL && MonoIsCoeff(m)) {
+        m = MonoNext(m);
+    }
+    return m == NULL;
+}
+
+Poly LeafFromMonos(const Mono *m)
+{
+    PolyLeaf *l = LeafNew((unsigned) MonoCountBlocks(m));
+    poly_exp_t *exps = LeafExps(l);
+
+    for (unsigned i = 0; m != NULL; m = MonoNext(m), i++) {
+        l->coeffs[i] = m->coeff.c;
+        exps[i] = m->exp;
+    }
+    return (Poly) {.tag = LEAF, .type.l = l};
+}
+
+Poly LeafExpand(const Poly *p)
+{
+    const PolyLeaf *l = p->type.l;
+    const poly_exp_t *exps = LeafExps(l);
+    Mono *arr = MonoArrayNew(l->count);
+
+    for (unsigned i = 0; i < l->count; i++) {
+        arr[i].exp = exps[i];
+        MonoSetPoly(&arr[i], PolyFromCoeff(l->coeffs[i]));
+    }
+    return (Poly) {.tag = ARRAY, .type.m = arr};
+}
+
+/**
+ * Dodaje do liścia liść pomnożony przez znak, scalając ich tablice.
+ * @param[in] a : liść
+ * @param[in] b : liść
+ * @param[in] sign : 1 dla sumy, -1 dla różnicy
+ * @return `a + sign * b`
+ */
+static Poly LeafAdd(const PolyLeaf *a, const PolyLeaf *b, poly_coeff_t sign)
+{
+    PolyLeaf *sum = LeafNew(a->count + b->count);
+    const poly_exp_t *exps_a = LeafExps(a), *exps_b = LeafExps(b);
+    poly_exp_t *exps = LeafExps(sum);
+    unsigned i = 0, j = 0, k = 0;
+    poly_coeff_t c;
+
+    while (i < a->count && j < b->count) {
+        if (exps_a[i] < exps_b[j]) {
+            exps[k] = exps_a[i];
+            sum->coeffs[k++] = a->coeffs[i++];
+        }
+        else if (exps_a[i] > exps_b[j]) {
+            exps[k] = exps_b[j];
+            sum->coeffs[k++] = CoeffMul(sign, b->coeffs[j++]);
+        }
+        else {
+            c = CoeffAdd(a->coeffs[i], CoeffMul(sign, b->coeffs[j]));
+            if (c != 0) {
+                exps[k] = exps_a[i];
+                sum->coeffs[k++] = c;
+            }
+            i++;
+            j++;
+        }
+    }
+    for (; i < a->count; i++, k++) {
+        exps[k] = exps_a[i];
+        sum->coeffs[k] = a->coeffs[i];
+    }
+    for (; j < b->count; j++, k++) {
+        exps[k] = exps_b[j];
+        sum->coeffs[k] = CoeffMul(sign, b->coeffs[j]);
+    }
+    return LeafFinish(sum, k);
+}
+
+Poly LeafAddCoeff(const PolyLeaf *a, poly_coeff_t c)
+{
+    const poly_exp_t *exps_a = LeafExps(a);
+    PolyLeaf *sum = LeafNew(a->count + 1);
+    poly_exp_t *exps = LeafExps(sum);
+    unsigned i = 0, k = 0;
+
+    if (exps_a[0] == 0) {
+        c = CoeffAdd(c, a->coeffs[0]);
+        i = 1;
+    }
+    if (c != 0) {
+        exps[k] = 0;
+        sum->coeffs[k++] = c;
+    }
+    for (; i < a->count; i++, k++) {
+        exps[k] = exps_a[i];
+        sum->coeffs[k] = a->coeffs[i];
+    }
+    return LeafFinish(sum, k);
+}
+
+Poly LeafScale(const PolyLeaf *a, poly_coeff_t c)
+{
+    const poly_exp_t *exps_a = LeafExps(a);
+    PolyLeaf *scaled = LeafNew(a->count);
+    poly_exp_t *exps = LeafExps(scaled);
+    unsigned k = 0;
+
+    for (unsigned i = 0; i < a->count; i++) {
+        if (CoeffMul(a->coeffs[i], c) != 0) {
+            exps[k] = exps_a[i];
+            scaled->coeffs[k++] = CoeffMul(a->coeffs[i], c);
+        }
+    }
+    return LeafFinish(scaled, k);
+}
+
+Poly LeafNeg(const PolyLeaf *a)
+{
+    PolyLeaf *neg = LeafNew(a->count);
+
+    for (unsigned i = 0; i < a->count; i++) {
+        neg->coeffs[i] = CoeffMul(a->coeffs[i], -1);
+    }
+    memcpy(LeafExps(neg), LeafExps(a), a->count * sizeof(poly_exp_t));
+    return (Poly) {.tag = LEAF, .type.l = neg};
+}
+
+poly_coeff_t LeafAt(const PolyLeaf *a, poly_coeff_t x)
+{
+    const poly_exp_t *exps = LeafExps(a);
+    unsigned i = a->count - 1;
+    poly_coeff_t value = a->coeffs[i];
+
+    while (i > 0) {
+        value = CoeffAdd(CoeffMul(value, PolyPower(x, exps[i] - exps[i - 1])),
+                         a->coeffs[i - 1]);
+        i--;
+    }
+    return CoeffMul(value, PolyPower(x, exps[0]));
+}
+
+bool LeafIsEq(const PolyLeaf *a, const Poly *q)
+{
+    const poly_exp_t *exps = LeafExps(a);
+    const Mono *m;
+    unsigned i = 0;
+
+    if (q->tag == LEAF) {
+        return a->count == q->type.l->count &&
+               memcmp(a->coeffs, q->type.l->coeffs,
+                      LeafSize(a->count) - sizeof(PolyLeaf)) == 0;
+    }
+    for (m = q->type.m; m != NULL && i < a->count; m = MonoNext(m), i++) {
+        if (m->exp != exps[i] || !MonoIsCoeff(m) ||
+            m->coeff.c != a->coeffs[i]) {
+            return false;
+        }
+    }
+    return m == NULL && i == a->count;
+}
+
+Poly PolyAddLeaf(const Poly *p, const Poly *q)
+{
+    Poly expanded, added;
+
+    if (p->tag != LEAF) {
+        return PolyAddLeaf(q, p);
+    }
+    else if (q->tag == LEAF) {
+        return LeafAdd(p->type.l, q->type.l, 1);
+    }
+    else if (PolyIsCoeff(q)) {
+        return LeafAddCoeff(p->type.l, q->type.c);
+    }
+    else {
+        expanded = LeafExpand(p);
+        added = PolyAdd(&expanded, q);
+        PolyDestroy(&expanded);
+        return added;
+    }
+}
+
+Poly PolySubLeaf(const Poly *p, const Poly *q)
+{
+    Poly expanded, subbed;
+
+    if (p->tag == LEAF && q->tag == LEAF) {
+        return LeafAdd(p->type.l, q->type.l, -1);
+    }
+    else if (p->tag == LEAF) {
+        expanded = LeafExpand(p);
+        subbed = PolySub(&expanded, q);
+    }
+    else {
+        expanded = LeafExpand(q);
+        subbed = PolySub(p, &expanded);
+    }
+    PolyDestroy(&expanded);
+    return subbed;
+}
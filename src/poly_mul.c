@@ -0,0 +1,1196 @@
+/** @file
+   Mnożenie wielomianów: scalanie kopcem, podstawienie Kroneckera, metoda
+   Karatsuby i wybór algorytmu według progów PolyMulTuning. Tu również
+   wartościowanie w wielu punktach drzewem podiloczynów, oparte na mnożeniu
+   gęstych wielomianów.
+
+   @author Piotr Szuberski <p.szuberski@student.uw.edu.pl>,
+   @copyright Uniwersytet Warszawski
+   @date 2026-10-18,
+*/
+
+#include <stddef.h>
+#include <string.h>
+#include "utils.h"
+#include "region.h"
+#include "ntt.h"
+#include "batch_eval.h"
+#include "poly_internal.h"
+
+/** Największa liczba zmiennych, dla której stosowane jest podstawienie
+ * Kroneckera */
+#define KRONECKER_MAX_VARS 16
+
+/** Liczba punktów w liściu drzewa podiloczynów; w tych punktach reszta
+ * wartościowana jest schematem Hornera */
+#define MULTIPOINT_BLOCK 64
+
+/**
+ * Para wykładnik i współczynnik, pomocnicza struktura dla LeafMul.
+ */
+typedef struct LeafTerm {
+    poly_exp_t exp; /**< exp : wykładnik */
+    poly_coeff_t coeff; /**< coeff : współczynnik */
+} LeafTerm;
+
+/**
+ * Element kopca scalającego iloczyny jednomianów w PolyMulHeap i LeafMul.
+ * Kopiec ma po jednym elemencie na każdy jednomian krótszego czynnika,
+ * element wskazuje kolejny jednomian dłuższego czynnika do wymnożenia.
+ */
+typedef struct MulHeapItem {
+    poly_exp_t exp; /**< exp : wykładnik iloczynu, klucz kopca */
+    unsigned row; /**< row : numer jednomianu krótszego czynnika */
+    /** col : bieżący jednomian dłuższego czynnika */
+    union {
+        const Mono *m; /**< m : jednomian (PolyMulHeap) */
+        unsigned k; /**< k : indeks w liściu (LeafMul) */
+    } col;
+} MulHeapItem;
+
+/**
+ * Przywraca własność kopca minimalnego po zmianie jego korzenia.
+ * @param[in] heap : kopiec
+ * @param[in] size : liczba elementów kopca
+ */
+static void MulHeapSiftDown(MulHeapItem heap[], unsigned size)
+{
+    MulHeapItem item = heap[0];
+    unsigned pos = 0, child;
+
+    while ((child = 2 * pos + 1) < size) {
+        if (child + 1 < size && heap[child + 1].exp < heap[child].exp) {
+            child++;
+        }
+        if (heap[child].exp >= item.exp) {
+            break;
+        }
+        heap[pos] = heap[child];
+        pos = child;
+    }
+    heap[pos] = item;
+}
+
+/**
+ * Mnoży dwa wielomiany normalne niebędące liśćmi. Iloczyny jednomianów
+ * powstają w kolejności rosnących wykładników dzięki kopcowi wielkości
+ * krótszego czynnika (algorytm Johnsona), więc iloczyny o równych
+ * wykładnikach są od razu sumowane, a pamięć pomocnicza nie zależy od
+ * liczby wszystkich iloczynów.
+ * @param[in] p : wielomian
+ * @param[in] q : wielomian
+ * @return `p * q`
+ */
+static Poly PolyMulHeap(const Poly *p, const Poly *q)
+{
+    RegionMark mark = RegionSave();
+    const Mono **rows, *helper, *next;
+    MulHeapItem *heap;
+    Mono *monos;
+    unsigned count_p, count_q, size, capacity, length = 0;
+    poly_exp_t exp;
+    Poly sum = PolyZero(), coeff_row, coeff_col, product, score;
+
+    count_p = (unsigned) MonoCountBlocks(p->type.m);
+    count_q = (unsigned) MonoCountBlocks(q->type.m);
+    if (count_p > count_q) {
+        const Poly *swap = p;
+        p = q;
+        q = swap;
+        size = count_q;
+    }
+    else {
+        size = count_p;
+    }
+    capacity = count_p + count_q;
+    rows = (const Mono**) RegionAlloc(sizeof(Mono*) * size);
+    heap = (MulHeapItem*) RegionAlloc(sizeof(MulHeapItem) * size);
+    monos = (Mono*) RegionAlloc(sizeof(Mono) * capacity);
+    helper = p->type.m;
+    for (unsigned i = 0; i < size; i++) {
+        rows[i] = helper;
+        heap[i].exp = helper->exp + q->type.m->exp;
+        heap[i].row = i;
+        heap[i].col.m = q->type.m;
+        helper = MonoNext(helper);
+    }
+    exp = heap[0].exp;
+    while (size > 0) {
+        if (heap[0].exp != exp) {
+            if (!PolyIsZero(&sum)) {
+                if (length == capacity) {
+                    monos = (Mono*) RegionRealloc(monos,
+                                                  sizeof(Mono) * capacity,
+                                                  sizeof(Mono) * capacity * 2);
+                    capacity *= 2;
+                }
+                monos[length++] = MonoFromPoly(&sum, exp);
+            }
+            sum = PolyZero();
+            exp = heap[0].exp;
+        }
+        coeff_row = MonoGetPoly(rows[heap[0].row]);
+        coeff_col = MonoGetPoly(heap[0].col.m);
+        product = PolyMul(&coeff_row, &coeff_col);
+        sum = PolyAddNoConsts(&sum, &product);
+        next = MonoNext(heap[0].col.m);
+        if (next != NULL) {
+            heap[0].exp = rows[heap[0].row]->exp + next->exp;
+            heap[0].col.m = next;
+        }
+        else {
+            heap[0] = heap[--size];
+        }
+        MulHeapSiftDown(heap, size);
+    }
+    if (!PolyIsZero(&sum)) {
+        if (length == capacity) {
+            monos = (Mono*) RegionRealloc(monos, sizeof(Mono) * capacity,
+                                          sizeof(Mono) * (capacity + 1));
+        }
+        monos[length++] = MonoFromPoly(&sum, exp);
+    }
+    score = PolyFromMonoArray(length, monos);
+    RegionRestore(mark);
+    return PolyInterned(score);
+}
+
+/**
+ * Podnosi do kwadratu wielomian normalny niebędący liściem, scalając
+ * iloczyny kopcem jak PolyMulHeap. Wiersz jednomianu `i` zaczyna się od
+ * jednomianu `i`, więc każdy iloczyn dwóch różnych jednomianów powstaje
+ * raz i mnożony jest przez podwojony współczynnik wiersza.
+ * @param[in] p : wielomian
+ * @return `p * p`
+ */
+static Poly PolySqrHeap(const Poly *p)
+{
+    RegionMark mark = RegionSave();
+    const Mono **rows, *helper, *next;
+    MulHeapItem *heap;
+    Mono *monos;
+    Poly *doubled;
+    unsigned count, size, capacity, length = 0;
+    poly_exp_t exp;
+    Poly sum = PolyZero(), coeff, product, score;
+
+    count = size = (unsigned) MonoCountBlocks(p->type.m);
+    capacity = 2 * count;
+    rows = (const Mono**) RegionAlloc(sizeof(Mono*) * count);
+    doubled = (Poly*) RegionAlloc(sizeof(Poly) * count);
+    heap = (MulHeapItem*) RegionAlloc(sizeof(MulHeapItem) * count);
+    monos = (Mono*) RegionAlloc(sizeof(Mono) * capacity);
+    helper = p->type.m;
+    for (unsigned i = 0; i < count; i++) {
+        rows[i] = helper;
+        coeff = MonoGetPoly(helper);
+        doubled[i] = PolyAdd(&coeff, &coeff);
+        heap[i].exp = helper->exp + helper->exp;
+        heap[i].row = i;
+        heap[i].col.m = helper;
+        helper = MonoNext(helper);
+    }
+    exp = heap[0].exp;
+    while (size > 0) {
+        if (heap[0].exp != exp) {
+            if (!PolyIsZero(&sum)) {
+                if (length == capacity) {
+                    monos = (Mono*) RegionRealloc(monos,
+                                                  sizeof(Mono) * capacity,
+                                                  sizeof(Mono) * capacity * 2);
+                    capacity *= 2;
+                }
+                monos[length++] = MonoFromPoly(&sum, exp);
+            }
+            sum = PolyZero();
+            exp = heap[0].exp;
+        }
+        coeff = MonoGetPoly(heap[0].col.m);
+        if (heap[0].col.m == rows[heap[0].row]) {
+            product = PolySqr(&coeff);
+        }
+        else {
+            product = PolyMul(&doubled[heap[0].row], &coeff);
+        }
+        sum = PolyAddNoConsts(&sum, &product);
+        next = MonoNext(heap[0].col.m);
+        if (next != NULL) {
+            heap[0].exp = rows[heap[0].row]->exp + next->exp;
+            heap[0].col.m = next;
+        }
+        else {
+            heap[0] = heap[--size];
+        }
+        MulHeapSiftDown(heap, size);
+    }
+    if (!PolyIsZero(&sum)) {
+        if (length == capacity) {
+            monos = (Mono*) RegionRealloc(monos, sizeof(Mono) * capacity,
+                                          sizeof(Mono) * (capacity + 1));
+        }
+        monos[length++] = MonoFromPoly(&sum, exp);
+    }
+    for (unsigned i = 0; i < count; i++) {
+        PolyDestroy(&doubled[i]);
+    }
+    score = PolyFromMonoArray(length, monos);
+    RegionRestore(mark);
+    return PolyInterned(score);
+}
+
+/**
+ * Sprawdza, czy opłaca się mnożyć czynniki metodą Karatsuby: oba muszą
+ * mieć co najmniej karatsuba_cutoff jednomianów i być gęste.
+ * @param[in] span_a : rozpiętość wykładników pierwszego czynnika
+ * @param[in] terms_a : liczba jednomianów pierwszego czynnika
+ * @param[in] span_b : rozpiętość wykładników drugiego czynnika
+ * @param[in] terms_b : liczba jednomianów drugiego czynnika
+ * @return czy stosować metodę Karatsuby?
+ */
+static inline bool KaratsubaPays(size_t span_a, size_t terms_a,
+                                 size_t span_b, size_t terms_b)
+{
+    return terms_a >= mul_tuning.karatsuba_cutoff &&
+           terms_b >= mul_tuning.karatsuba_cutoff &&
+           span_a <= mul_tuning.karatsuba_density * terms_a &&
+           span_b <= mul_tuning.karatsuba_density * terms_b;
+}
+
+/**
+ * Mnoży wielomiany mnożeniem szkolnym.
+ * @param[in] a : współczynniki pierwszego czynnika
+ * @param[in] n : długość @p a
+ * @param[in] b : współczynniki drugiego czynnika
+ * @param[in] m : długość @p b
+ * @param[out] out : współczynniki iloczynu, tablica długości `n + m - 1`
+ */
+static void SchoolbookMul(const unsigned long a[], size_t n,
+                          const unsigned long b[], size_t m,
+                          unsigned long out[])
+{
+    memset(out, 0, sizeof(unsigned long) * (n + m - 1));
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < m; j++) {
+            out[i + j] += a[i] * b[j];
+        }
+    }
+}
+
+/**
+ * Mnoży metodą Karatsuby czynniki równej długości.
+ * @param[in] a : współczynniki pierwszego czynnika
+ * @param[in] b : współczynniki drugiego czynnika
+ * @param[in] n : długość obu czynników
+ * @param[out] out : współczynniki iloczynu, tablica długości `2n - 1`
+ */
+static void KaratsubaBalanced(const unsigned long a[],
+                              const unsigned long b[], size_t n,
+                              unsigned long out[])
+{
+    RegionMark mark;
+    size_t low = n / 2, high = n - low;
+    unsigned long *sum_a, *sum_b, *mid;
+
+    if (n < 2 * mul_tuning.karatsuba_cutoff) {
+        SchoolbookMul(a, n, b, n, out);
+        return;
+    }
+    mark = RegionSave();
+    sum_a = (unsigned long*) RegionAlloc(sizeof(unsigned long) * high);
+    sum_b = (unsigned long*) RegionAlloc(sizeof(unsigned long) * high);
+    mid = (unsigned long*) RegionAlloc(sizeof(unsigned long) * (2 * high - 1));
+    KaratsubaBalanced(a, b, low, out);
+    out[2 * low - 1] = 0;
+    KaratsubaBalanced(a + low, b + low, high, out + 2 * low);
+    for (size_t i = 0; i < high; i++) {
+        sum_a[i] = a[low + i] + (i < low ? a[i] : 0);
+        sum_b[i] = b[low + i] + (i < low ? b[i] : 0);
+    }
+    KaratsubaBalanced(sum_a, sum_b, high, mid);
+    for (size_t i = 0; i < 2 * low - 1; i++) {
+        mid[i] -= out[i];
+    }
+    for (size_t i = 0; i < 2 * high - 1; i++) {
+        mid[i] -= out[2 * low + i];
+    }
+    for (size_t i = 0; i < 2 * high - 1; i++) {
+        out[low + i] += mid[i];
+    }
+    RegionRestore(mark);
+}
+
+/**
+ * Mnoży gęste wielomiany jednej zmiennej o stałych współczynnikach
+ * metodą Karatsuby. Arytmetyka jest modulo 2^64, jak przy mnożeniu
+ * szkolnym, więc wynik jest identyczny.
+ * @param[in] a : współczynniki pierwszego czynnika
+ * @param[in] n : długość @p a
+ * @param[in] b : współczynniki drugiego czynnika
+ * @param[in] m : długość @p b
+ * @param[out] out : współczynniki iloczynu, tablica długości `n + m - 1`
+ */
+static void KaratsubaMul(const unsigned long a[], size_t n,
+                         const unsigned long b[], size_t m,
+                         unsigned long out[])
+{
+    RegionMark mark;
+    unsigned long *part;
+    size_t len;
+
+    if (n < m) {
+        KaratsubaMul(b, m, a, n, out);
+        return;
+    }
+    if (n == m) {
+        KaratsubaBalanced(a, b, n, out);
+        return;
+    }
+    if (m < mul_tuning.karatsuba_cutoff) {
+        SchoolbookMul(a, n, b, m, out);
+        return;
+    }
+    mark = RegionSave();
+    part = (unsigned long*) RegionAlloc(sizeof(unsigned long) * (2 * m - 1));
+    memset(out, 0, sizeof(unsigned long) * (n + m - 1));
+    for (size_t off = 0; off < n; off += m) {
+        len = n - off < m ? n - off : m;
+        KaratsubaMul(a + off, len, b, m, part);
+        for (size_t i = 0; i < len + m - 1; i++) {
+            out[off + i] += part[i];
+        }
+    }
+    RegionRestore(mark);
+}
+
+/**
+ * Sprawdza, czy opłaca się mnożyć gęste czynniki przez NttMul: krótszy
+ * czynnik musi mieć co najmniej ntt_threshold współczynników, a próg
+ * rośnie ntt_prime_factor razy z każdą kolejną liczbą pierwszą potrzebną
+ * NttMul.
+ * @param[in] a : współczynniki pierwszego czynnika
+ * @param[in] n : długość @p a
+ * @param[in] b : współczynniki drugiego czynnika
+ * @param[in] m : długość @p b
+ * @return czy stosować NttMul?
+ */
+static bool NttPays(const unsigned long a[], size_t n,
+                    const unsigned long b[], size_t m)
+{
+    size_t threshold = mul_tuning.ntt_threshold;
+    unsigned primes;
+
+    if ((n < m ? n : m) < threshold) {
+        return false;
+    }
+    primes = NttPrimesNeeded(a, n, b, m);
+    for (unsigned k = 1; k < primes; k++) {
+        threshold = threshold > SIZE_MAX / mul_tuning.ntt_prime_factor ?
+                    SIZE_MAX : threshold * mul_tuning.ntt_prime_factor;
+    }
+    return (n < m ? n : m) >= threshold;
+}
+
+/**
+ * Mnoży gęste wielomiany jednej zmiennej o stałych współczynnikach,
+ * wybierając NttMul albo KaratsubaMul według NttPays.
+ * @param[in] a : współczynniki pierwszego czynnika
+ * @param[in] n : długość @p a
+ * @param[in] b : współczynniki drugiego czynnika
+ * @param[in] m : długość @p b
+ * @param[out] out : współczynniki iloczynu, tablica długości `n + m - 1`
+ */
+static void DenseMul(const unsigned long a[], size_t n,
+                     const unsigned long b[], size_t m, unsigned long out[])
+{
+    if (NttPays(a, n, b, m)) {
+        NttMul(a, n, b, m, out);
+    }
+    else {
+        KaratsubaMul(a, n, b, m, out);
+    }
+}
+
+/**
+ * Podnosi wielomian do kwadratu mnożeniem szkolnym, licząc każdy iloczyn
+ * dwóch różnych współczynników raz.
+ * @param[in] a : współczynniki wielomianu
+ * @param[in] n : długość @p a
+ * @param[out] out : współczynniki kwadratu, tablica długości `2n - 1`
+ */
+static void SchoolbookSqr(const unsigned long a[], size_t n,
+                          unsigned long out[])
+{
+    memset(out, 0, sizeof(unsigned long) * (2 * n - 1));
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = i + 1; j < n; j++) {
+            out[i + j] += a[i] * a[j];
+        }
+    }
+    for (size_t k = 0; k < 2 * n - 1; k++) {
+        out[k] *= 2;
+    }
+    for (size_t i = 0; i < n; i++) {
+        out[2 * i] += a[i] * a[i];
+    }
+}
+
+/**
+ * Podnosi do kwadratu metodą Karatsuby gęsty wielomian jednej zmiennej
+ * o stałych współczynnikach. Zamiast trzech iloczynów połówek liczy trzy
+ * kwadraty, a kwadraty krótkich wielomianów liczą każdy iloczyn dwóch
+ * różnych współczynników raz.
+ * @param[in] a : współczynniki wielomianu
+ * @param[in] n : długość @p a
+ * @param[out] out : współczynniki kwadratu, tablica długości `2n - 1`
+ */
+static void KaratsubaSqr(const unsigned long a[], size_t n,
+                         unsigned long out[])
+{
+    RegionMark mark;
+    size_t low = n / 2, high = n - low;
+    unsigned long *sum, *mid;
+
+    if (n < 2 * mul_tuning.karatsuba_cutoff) {
+        SchoolbookSqr(a, n, out);
+        return;
+    }
+    mark = RegionSave();
+    sum = (unsigned long*) RegionAlloc(sizeof(unsigned long) * high);
+    mid = (unsigned long*) RegionAlloc(sizeof(unsigned long) * (2 * high - 1));
+    KaratsubaSqr(a, low, out);
+    out[2 * low - 1] = 0;
+    KaratsubaSqr(a + low, high, out + 2 * low);
+    for (size_t i = 0; i < high; i++) {
+        sum[i] = a[low + i] + (i < low ? a[i] : 0);
+    }
+    KaratsubaSqr(sum, high, mid);
+    for (size_t i = 0; i < 2 * low - 1; i++) {
+        mid[i] -= out[i];
+    }
+    for (size_t i = 0; i < 2 * high - 1; i++) {
+        mid[i] -= out[2 * low + i];
+    }
+    for (size_t i = 0; i < 2 * high - 1; i++) {
+        out[low + i] += mid[i];
+    }
+    RegionRestore(mark);
+}
+
+/**
+ * Podnosi do kwadratu gęsty wielomian jednej zmiennej o stałych
+ * współczynnikach, wybierając NttMul albo KaratsubaSqr według NttPays.
+ * @param[in] a : współczynniki wielomianu
+ * @param[in] n : długość @p a
+ * @param[out] out : współczynniki kwadratu, tablica długości `2n - 1`
+ */
+static void DenseSqr(const unsigned long a[], size_t n, unsigned long out[])
+{
+    if (NttPays(a, n, a, n)) {
+        NttMul(a, n, a, n, out);
+    }
+    else {
+        KaratsubaSqr(a, n, out);
+    }
+}
+
+/**
+ * Wylicza odwrotność szeregu potęgowego metodą Newtona, podwajając
+ * w każdym kroku liczbę poprawnych współczynników.
+ * @param[in] f : współczynniki szeregu, `f[0] = 1`
+ * @param[in] n : długość @p f
+ * @param[in] l : liczba szukanych współczynników odwrotności
+ * @param[out] g : `f^(-1) mod x^l`, tablica długości @p l
+ */
+static void SeriesInverse(const unsigned long f[], size_t n, size_t l,
+                          unsigned long g[])
+{
+    RegionMark mark = RegionSave();
+    unsigned long *prod, *high;
+    size_t t = 1, next, len;
+
+    prod = (unsigned long*) RegionAlloc(sizeof(unsigned long) * 2 * l);
+    high = (unsigned long*) RegionAlloc(sizeof(unsigned long) * l);
+    g[0] = 1;
+    while (t < l) {
+        next = 2 * t < l ? 2 * t : l;
+        len = n < next ? n : next;
+        DenseMul(f, len, g, t, prod);
+        for (size_t i = t; i < next; i++) {
+            high[i - t] = i < len + t - 1 ? prod[i] : 0;
+        }
+        DenseMul(g, next - t, high, next - t, prod);
+        for (size_t i = t; i < next; i++) {
+            g[i] = -prod[i - t];
+        }
+        t = next;
+    }
+    RegionRestore(mark);
+}
+
+/**
+ * Wylicza skalowaną resztę wielomianu w korzeniu drzewa podiloczynów:
+ * współczynniki przy `x^(-1), ..., x^(-D)` szeregu `p / m` w zmiennej 1/x,
+ * gdzie D to stopień @p m. Szereg liczony jest z odwrócenia @p m, którego
+ * wyraz wolny to 1, więc wynik jest dokładny modulo 2^64.
+ * @param[in] p : współczynniki wielomianu
+ * @param[in] n : długość @p p
+ * @param[in] m : współczynniki wielomianu unormowanego, `m[len - 1] = 1`
+ * @param[in] len : długość @p m, równa `D + 1`
+ * @param[out] z : współczynnik przy `x^(u - D)` na pozycji u, tablica
+ * długości D
+ */
+static void DenseScaledRoot(const unsigned long p[], size_t n,
+                            const unsigned long m[], size_t len,
+                            unsigned long z[])
+{
+    RegionMark mark = RegionSave();
+    unsigned long *rev, *inv, *prod;
+    size_t deg = len - 1;
+
+    rev = (unsigned long*) RegionAlloc(sizeof(unsigned long) *
+                                       (n > len ? n : len));
+    inv = (unsigned long*) RegionAlloc(sizeof(unsigned long) * n);
+    prod = (unsigned long*) RegionAlloc(sizeof(unsigned long) * (2 * n - 1));
+    for (size_t i = 0; i < len; i++) {
+        rev[i] = m[deg - i];
+    }
+    SeriesInverse(rev, len, n, inv);
+    for (size_t i = 0; i < n; i++) {
+        rev[i] = p[n - 1 - i];
+    }
+    DenseMul(rev, n, inv, n, prod);
+    for (size_t u = 0; u < deg; u++) {
+        z[u] = u < n ? prod[n - 1 - u] : 0;
+    }
+    RegionRestore(mark);
+}
+
+/**
+ * Wylicza wartości gęstego wielomianu w punktach drzewem podiloczynów:
+ * buduje iloczyny `(x - xs[j])` dla coraz większych grup punktów, a potem
+ * schodzi od korzenia drzewem skalowanych reszt. Skalowana reszta grupy
+ * o iloczynie m to początek szeregu `(p mod m) / m` w zmiennej 1/x;
+ * reszty dzieci są fragmentami iloczynów reszty rodzica i wielomianu
+ * rodzeństwa, więc zejście nie wymaga dzielenia. Reszty dla grup
+ * MULTIPOINT_BLOCK punktów zamieniane są z powrotem na `p mod m`
+ * i wartościowane schematem Hornera.
+ * @param[in] p : współczynniki wielomianu
+ * @param[in] n : długość @p p
+ * @param[in] k : liczba punktów, dodatnia
+ * @param[in] xs : punkty
+ * @param[out] out : wartości w punktach
+ */
+static void DenseAtManyTree(const unsigned long p[], size_t n, size_t k,
+                            const unsigned long xs[], unsigned long out[])
+{
+    RegionMark mark = RegionSave();
+    unsigned long **tree, *node, *left, *right, *values, *child_values;
+    unsigned long *prod, *swap;
+    size_t levels = 1, size, count, points;
+    int *exps;
+
+    for (size = MULTIPOINT_BLOCK; size < k; size *= 2) {
+        levels++;
+    }
+    tree = (unsigned long**) RegionAlloc(sizeof(unsigned long*) * levels);
+    count = (k + MULTIPOINT_BLOCK - 1) / MULTIPOINT_BLOCK;
+    tree[0] = (unsigned long*) RegionAlloc(sizeof(unsigned long) *
+                                           (k + count));
+    for (size_t i = 0; i < count; i++) {
+        node = tree[0] + i * (MULTIPOINT_BLOCK + 1);
+        points = k - i * MULTIPOINT_BLOCK < MULTIPOINT_BLOCK ?
+                 k - i * MULTIPOINT_BLOCK : MULTIPOINT_BLOCK;
+        node[0] = 1;
+        for (size_t j = 0; j < points; j++) {
+            node[j + 1] = node[j];
+            for (size_t t = j; t > 0; t--) {
+                node[t] = node[t - 1] - xs[i * MULTIPOINT_BLOCK + j] * node[t];
+            }
+            node[0] = -xs[i * MULTIPOINT_BLOCK + j] * node[0];
+        }
+    }
+    size = MULTIPOINT_BLOCK;
+    for (size_t l = 1; l < levels; l++) {
+        count = (count + 1) / 2;
+        tree[l] = (unsigned long*) RegionAlloc(sizeof(unsigned long) *
+                                               (k + count));
+        for (size_t i = 0; i < count; i++) {
+            node = tree[l] + i * (2 * size + 1);
+            points = k - 2 * i * size;
+            if (points <= size) {
+                memcpy(node, tree[l - 1] + 2 * i * (size + 1),
+                       sizeof(unsigned long) * (points + 1));
+            }
+            else {
+                DenseMul(tree[l - 1] + 2 * i * (size + 1), size + 1,
+                         tree[l - 1] + (2 * i + 1) * (size + 1),
+                         (points < 2 * size ? points : 2 * size) - size + 1,
+                         node);
+            }
+        }
+        size *= 2;
+    }
+    values = (unsigned long*) RegionAlloc(sizeof(unsigned long) * k);
+    child_values = (unsigned long*) RegionAlloc(sizeof(unsigned long) * k);
+    prod = (unsigned long*) RegionAlloc(sizeof(unsigned long) * 2 * k);
+    DenseScaledRoot(p, n, tree[levels - 1], k + 1, values);
+    for (size_t l = levels - 1; l > 0; l--) {
+        size /= 2;
+        for (size_t start = 0; start < k; start += 2 * size) {
+            points = k - start < 2 * size ? k - start : 2 * size;
+            left = tree[l - 1] + (start / size) * (size + 1);
+            right = left + size + 1;
+            if (points <= size) {
+                memcpy(child_values + start, values + start,
+                       sizeof(unsigned long) * points);
+            }
+            else {
+                DenseMul(values + start, points, right, points - size + 1,
+                         prod);
+                memcpy(child_values + start, prod + points - size,
+                       sizeof(unsigned long) * size);
+                DenseMul(values + start, points, left, size + 1, prod);
+                memcpy(child_values + start + size, prod + size,
+                       sizeof(unsigned long) * (points - size));
+            }
+        }
+        swap = values;
+        values = child_values;
+        child_values = swap;
+    }
+    exps = (int*) RegionAlloc(sizeof(int) * MULTIPOINT_BLOCK);
+    for (int i = 0; i < MULTIPOINT_BLOCK; i++) {
+        exps[i] = i;
+    }
+    for (size_t i = 0; i < k; i += MULTIPOINT_BLOCK) {
+        points = k - i < MULTIPOINT_BLOCK ? k - i : MULTIPOINT_BLOCK;
+        DenseMul(values + i, points, tree[0] + (i / MULTIPOINT_BLOCK) *
+                 (MULTIPOINT_BLOCK + 1), points + 1, prod);
+        BatchHorner(prod + points, exps, (unsigned) points, points, xs + i,
+                    out + i);
+    }
+    RegionRestore(mark);
+}
+
+bool MultipointPays(const PolyLeaf *a, size_t k)
+{
+    size_t span = (size_t) LeafExps(a)[a->count - 1] + 1;
+
+    return k >= mul_tuning.multipoint_threshold &&
+           span >= mul_tuning.multipoint_threshold &&
+           span <= mul_tuning.karatsuba_density * a->count;
+}
+
+void LeafAtManyTree(const PolyLeaf *a, size_t k,
+                    const poly_coeff_t xs[], poly_coeff_t out[])
+{
+    RegionMark mark = RegionSave();
+    const poly_exp_t *exps = LeafExps(a);
+    size_t span = (size_t) exps[a->count - 1] + 1, chunk;
+    unsigned long *dense;
+
+    dense = (unsigned long*) RegionAlloc(sizeof(unsigned long) * span);
+    memset(dense, 0, sizeof(unsigned long) * span);
+    for (unsigned i = 0; i < a->count; i++) {
+        dense[exps[i]] = (unsigned long) a->coeffs[i];
+    }
+    for (size_t s = 0; s < k; s += span) {
+        chunk = k - s < span ? k - s : span;
+        DenseAtManyTree(dense, span, chunk, (const unsigned long*) xs + s,
+                        (unsigned long*) out + s);
+    }
+    RegionRestore(mark);
+}
+
+/**
+ * Wyznacza stopnie wielomianu względem kolejnych zmiennych (jak PolyDegBy
+ * dla każdej zmiennej), liczbę zmiennych i liczbę jednomianów
+ * o stałych współczynnikach w jednym przejściu.
+ * @param[in] p : wielomian normalny
+ * @param[in] degs : wyzerowana tablica KRONECKER_MAX_VARS stopni
+ * @param[in] vars : liczba zmiennych
+ * @param[in] terms : liczba jednomianów o stałych współczynnikach
+ * @return czy liczba zmiennych nie przekracza KRONECKER_MAX_VARS?
+ */
+static bool PolyKroneckerScan(const Poly *p, poly_exp_t degs[],
+                              unsigned *vars, size_t *terms)
+{
+    struct {
+        Poly level;
+        unsigned depth;
+    } item, child;
+    WorkStack pending;
+    Mono *helper;
+    bool fits = true;
+
+    *vars = 0;
+    *terms = 0;
+    WorkStackInit(&pending, sizeof(item));
+    item.level = *p;
+    item.depth = 0;
+    do {
+        if (item.depth >= KRONECKER_MAX_VARS) {
+            fits = false;
+            break;
+        }
+        if (item.depth + 1 > *vars) {
+            *vars = item.depth + 1;
+        }
+        if (item.level.tag == LEAF) {
+            *terms += item.level.type.l->count;
+            helper = NULL;
+            if (LeafExps(item.level.type.l)[item.level.type.l->count - 1] >
+                degs[item.depth]) {
+                degs[item.depth] =
+                    LeafExps(item.level.type.l)[item.level.type.l->count - 1];
+            }
+        }
+        else {
+            helper = item.level.type.m;
+        }
+        for (; helper != NULL; helper = MonoNext(helper)) {
+            if (helper->exp > degs[item.depth]) {
+                degs[item.depth] = helper->exp;
+            }
+            child.level = MonoGetPoly(helper);
+            child.depth = item.depth + 1;
+            if (PolyIsCoeff(&child.level)) {
+                (*terms)++;
+            }
+            else {
+                WorkStackPush(&pending, &child);
+            }
+        }
+    } while (WorkStackPop(&pending, &item));
+    WorkStackFree(&pending);
+    return fits;
+}
+
+/**
+ * Zamienia wielomian wielu zmiennych na wielomian jednej zmiennej,
+ * podstawiając za zmienną o indeksie i potęgę o wykładniku weights[i].
+ * @param[in] p : wielomian normalny
+ * @param[in] weights : wagi zmiennych
+ * @param[in] keys : wykładniki jednomianów wyniku
+ * @param[in] coeffs : współczynniki jednomianów wyniku
+ */
+static void PolyKroneckerFlatten(const Poly *p, const size_t weights[],
+                                 size_t keys[], poly_coeff_t coeffs[])
+{
+    struct {
+        Poly level;
+        unsigned depth;
+        size_t key;
+    } item, child;
+    WorkStack pending;
+    const PolyLeaf *leaf;
+    Mono *helper;
+    size_t n = 0;
+
+    WorkStackInit(&pending, sizeof(item));
+    item.level = *p;
+    item.depth = 0;
+    item.key = 0;
+    do {
+        if (item.level.tag == LEAF) {
+            leaf = item.level.type.l;
+            for (unsigned i = 0; i < leaf->count; i++) {
+                keys[n] = item.key + (size_t) LeafExps(leaf)[i] *
+                                     weights[item.depth];
+                coeffs[n++] = leaf->coeffs[i];
+            }
+            continue;
+        }
+        for (helper = item.level.type.m; helper != NULL;
+             helper = MonoNext(helper)) {
+            child.level = MonoGetPoly(helper);
+            child.depth = item.depth + 1;
+            child.key = item.key + (size_t) helper->exp * weights[item.depth];
+            if (PolyIsCoeff(&child.level)) {
+                keys[n] = child.key;
+                coeffs[n++] = child.level.type.c;
+            }
+            else {
+                WorkStackPush(&pending, &child);
+            }
+        }
+    } while (WorkStackPop(&pending, &item));
+    WorkStackFree(&pending);
+}
+
+/**
+ * Odtwarza poziom wielomianu wielu zmiennych z gęstej tablicy
+ * współczynników wielomianu jednej zmiennej.
+ * @param[in] acc : współczynniki wielomianu jednej zmiennej
+ * @param[in] key : wykładnik odpowiadający początkowi poziomu
+ * @param[in] depth : indeks zmiennej poziomu
+ * @param[in] vars : liczba zmiennych
+ * @param[in] bases : ograniczenia wykładników kolejnych zmiennych
+ * @param[in] weights : wagi zmiennych
+ * @return poziom wielomianu
+ */
+static Poly PolyKroneckerBuild(const poly_coeff_t acc[], size_t key,
+                               unsigned depth, unsigned vars,
+                               const size_t bases[], const size_t weights[])
+{
+    RegionMark mark = RegionSave();
+    Mono *monos = (Mono*) RegionAlloc(sizeof(Mono) * bases[depth]);
+    unsigned length = 0;
+    Poly coeff, level;
+
+    for (size_t e = 0; e < bases[depth]; e++) {
+        if (depth + 1 == vars) {
+            coeff = PolyFromCoeff(acc[key + e]);
+        }
+        else {
+            coeff = PolyKroneckerBuild(acc, key + e * weights[depth],
+                                       depth + 1, vars, bases, weights);
+        }
+        if (!PolyIsZero(&coeff)) {
+            monos[length++] = MonoFromPoly(&coeff, (poly_exp_t) e);
+        }
+    }
+    level = PolyFromMonoArray(length, monos);
+    RegionRestore(mark);
+    return PolyInterned(level);
+}
+
+/**
+ * Mnoży wielomiany wielu zmiennych przez podstawienie Kroneckera: oba
+ * czynniki zamieniane są na wielomiany jednej zmiennej, mnożone w jednej
+ * gęstej tablicy, a wynik jest z powrotem rozkładany na poziomy.
+ * Stosowane tylko, gdy czynniki są dostatecznie gęste. Gdy @p p i @p q
+ * to ten sam wskaźnik, wielomian jest podnoszony do kwadratu: zamieniany
+ * jest raz, a każdy iloczyn dwóch różnych jednomianów liczony jest raz.
+ * @param[in] p : wielomian normalny
+ * @param[in] q : wielomian normalny
+ * @param[in] product : iloczyn `p * q`
+ * @return czy iloczyn został policzony?
+ */
+static bool PolyMulKronecker(const Poly *p, const Poly *q, Poly *product)
+{
+    poly_exp_t degs_p[KRONECKER_MAX_VARS] = {0};
+    poly_exp_t degs_q[KRONECKER_MAX_VARS] = {0};
+    size_t bases[KRONECKER_MAX_VARS], weights[KRONECKER_MAX_VARS];
+    size_t terms_p, terms_q, span = 1, span_p = 0, span_q = 0;
+    size_t *keys_p, *keys_q;
+    poly_coeff_t *coeffs_p, *coeffs_q;
+    unsigned long *dense_p, *dense_q, *acc;
+    unsigned vars_p, vars_q, vars;
+    bool square = p == q;
+    RegionMark mark;
+
+    if (!PolyKroneckerScan(p, degs_p, &vars_p, &terms_p)) {
+        return false;
+    }
+    if (square) {
+        memcpy(degs_q, degs_p, sizeof(degs_p));
+        vars_q = vars_p;
+        terms_q = terms_p;
+    }
+    else if (!PolyKroneckerScan(q, degs_q, &vars_q, &terms_q)) {
+        return false;
+    }
+    vars = vars_p > vars_q ? vars_p : vars_q;
+    if (vars < 2 || terms_p * terms_q < mul_tuning.kronecker_min_products) {
+        return false;
+    }
+    for (unsigned i = vars; i-- > 0;) {
+        bases[i] = (size_t) degs_p[i] + (size_t) degs_q[i] + 1;
+        weights[i] = span;
+        if (bases[i] > mul_tuning.kronecker_max_span / span) {
+            return false;
+        }
+        span *= bases[i];
+    }
+    if (span / mul_tuning.kronecker_sparsity > terms_p * terms_q) {
+        return false;
+    }
+    mark = RegionSave();
+    keys_p = (size_t*) RegionAlloc(sizeof(size_t) * terms_p);
+    coeffs_p = (poly_coeff_t*) RegionAlloc(sizeof(poly_coeff_t) * terms_p);
+    PolyKroneckerFlatten(p, weights, keys_p, coeffs_p);
+    if (square) {
+        keys_q = keys_p;
+        coeffs_q = coeffs_p;
+    }
+    else {
+        keys_q = (size_t*) RegionAlloc(sizeof(size_t) * terms_q);
+        coeffs_q = (poly_coeff_t*) RegionAlloc(sizeof(poly_coeff_t) *
+                                               terms_q);
+        PolyKroneckerFlatten(q, weights, keys_q, coeffs_q);
+    }
+    acc = (unsigned long*) RegionAlloc(sizeof(unsigned long) * span);
+    memset(acc, 0, sizeof(unsigned long) * span);
+    for (size_t i = 0; i < terms_p; i++) {
+        span_p = keys_p[i] >= span_p ? keys_p[i] + 1 : span_p;
+    }
+    for (size_t j = 0; j < terms_q; j++) {
+        span_q = keys_q[j] >= span_q ? keys_q[j] + 1 : span_q;
+    }
+    if (KaratsubaPays(span_p, terms_p, span_q, terms_q)) {
+        dense_p = (unsigned long*) RegionAlloc(sizeof(unsigned long) * span_p);
+        memset(dense_p, 0, sizeof(unsigned long) * span_p);
+        for (size_t i = 0; i < terms_p; i++) {
+            dense_p[keys_p[i]] = (unsigned long) coeffs_p[i];
+        }
+        if (square) {
+            DenseSqr(dense_p, span_p, acc);
+        }
+        else {
+            dense_q = (unsigned long*) RegionAlloc(sizeof(unsigned long) *
+                                                   span_q);
+            memset(dense_q, 0, sizeof(unsigned long) * span_q);
+            for (size_t j = 0; j < terms_q; j++) {
+                dense_q[keys_q[j]] = (unsigned long) coeffs_q[j];
+            }
+            DenseMul(dense_p, span_p, dense_q, span_q, acc);
+        }
+    }
+    else if (square) {
+        for (size_t i = 0; i < terms_p; i++) {
+            for (size_t j = i + 1; j < terms_p; j++) {
+                acc[keys_p[i] + keys_p[j]] += (unsigned long) coeffs_p[i] *
+                                              (unsigned long) coeffs_p[j];
+            }
+        }
+        for (size_t k = 0; k < span; k++) {
+            acc[k] *= 2;
+        }
+        for (size_t i = 0; i < terms_p; i++) {
+            acc[2 * keys_p[i]] += (unsigned long) coeffs_p[i] *
+                                  (unsigned long) coeffs_p[i];
+        }
+    }
+    else {
+        for (size_t i = 0; i < terms_p; i++) {
+            for (size_t j = 0; j < terms_q; j++) {
+                acc[keys_p[i] + keys_q[j]] += (unsigned long) coeffs_p[i] *
+                                              (unsigned long) coeffs_q[j];
+            }
+        }
+    }
+    *product = PolyKroneckerBuild((const poly_coeff_t*) acc, 0, 0, vars,
+                                  bases, weights);
+    RegionRestore(mark);
+    return true;
+}
+
+/**
+ * Mnoży dwa gęste liście przez DenseMul, a gdy @p a i @p b to ten sam
+ * wskaźnik, podnosi liść do kwadratu przez DenseSqr.
+ * @param[in] a : liść
+ * @param[in] b : liść
+ * @return `a * b`
+ */
+static Poly LeafMulDense(const PolyLeaf *a, const PolyLeaf *b)
+{
+    RegionMark mark = RegionSave();
+    const poly_exp_t *exps_a = LeafExps(a), *exps_b = LeafExps(b);
+    poly_exp_t base_a = exps_a[0], base_b = exps_b[0];
+    size_t span_a = (size_t) (exps_a[a->count - 1] - base_a) + 1;
+    size_t span_b = (size_t) (exps_b[b->count - 1] - base_b) + 1;
+    unsigned long *dense_a, *dense_b, *out;
+    PolyLeaf *product;
+    unsigned length = 0;
+
+    dense_a = (unsigned long*) RegionAlloc(sizeof(unsigned long) * span_a);
+    out = (unsigned long*) RegionAlloc(sizeof(unsigned long) *
+                                       (span_a + span_b - 1));
+    memset(dense_a, 0, sizeof(unsigned long) * span_a);
+    for (unsigned i = 0; i < a->count; i++) {
+        dense_a[exps_a[i] - base_a] = (unsigned long) a->coeffs[i];
+    }
+    if (a == b) {
+        DenseSqr(dense_a, span_a, out);
+    }
+    else {
+        dense_b = (unsigned long*) RegionAlloc(sizeof(unsigned long) * span_b);
+        memset(dense_b, 0, sizeof(unsigned long) * span_b);
+        for (unsigned i = 0; i < b->count; i++) {
+            dense_b[exps_b[i] - base_b] = (unsigned long) b->coeffs[i];
+        }
+        DenseMul(dense_a, span_a, dense_b, span_b, out);
+    }
+    for (size_t i = 0; i < span_a + span_b - 1; i++) {
+        length += out[i] != 0;
+    }
+    if (length == 0) {
+        RegionRestore(mark);
+        return PolyZero();
+    }
+    product = LeafNew(length);
+    length = 0;
+    for (size_t i = 0; i < span_a + span_b - 1; i++) {
+        if (out[i] != 0) {
+            product->coeffs[length] = (poly_coeff_t) out[i];
+            LeafExps(product)[length++] = base_a + base_b + (poly_exp_t) i;
+        }
+    }
+    RegionRestore(mark);
+    return LeafFinish(product, length);
+}
+
+/**
+ * Mnoży dwa liście. Gdy @p a i @p b to ten sam wskaźnik, liść jest
+ * podnoszony do kwadratu i każdy iloczyn dwóch różnych jednomianów
+ * liczony jest raz.
+ * @param[in] a : liść
+ * @param[in] b : liść
+ * @return `a * b`
+ */
+static Poly LeafMul(const PolyLeaf *a, const PolyLeaf *b)
+{
+    RegionMark mark;
+    const poly_exp_t *exps_a, *exps_b;
+    MulHeapItem *heap;
+    LeafTerm *terms;
+    PolyLeaf *product;
+    unsigned size, capacity, length = 0;
+    bool square = a == b;
+    unsigned long c;
+
+    if (a->count > b->count) {
+        return LeafMul(b, a);
+    }
+    if (KaratsubaPays((size_t) (LeafExps(a)[a->count - 1] - LeafExps(a)[0]) + 1,
+                      a->count,
+                      (size_t) (LeafExps(b)[b->count - 1] - LeafExps(b)[0]) + 1,
+                      b->count)) {
+        return LeafMulDense(a, b);
+    }
+    mark = RegionSave();
+    exps_a = LeafExps(a);
+    exps_b = LeafExps(b);
+    size = a->count;
+    capacity = a->count + b->count;
+    heap = (MulHeapItem*) RegionAlloc(sizeof(MulHeapItem) * size);
+    terms = (LeafTerm*) RegionAlloc(sizeof(LeafTerm) * capacity);
+    for (unsigned i = 0; i < size; i++) {
+        heap[i].row = i;
+        heap[i].col.k = square ? i : 0;
+        heap[i].exp = exps_a[i] + exps_b[heap[i].col.k];
+    }
+    while (size > 0) {
+        c = (unsigned long) a->coeffs[heap[0].row] *
+            (unsigned long) b->coeffs[heap[0].col.k];
+        if (square && heap[0].col.k != heap[0].row) {
+            c *= 2;
+        }
+        if (length > 0 && terms[length - 1].exp == heap[0].exp) {
+            terms[length - 1].coeff = (poly_coeff_t)
+                ((unsigned long) terms[length - 1].coeff + c);
+        }
+        else {
+            if (length > 0 && terms[length - 1].coeff == 0) {
+                length--;
+            }
+            if (length == capacity) {
+                terms = (LeafTerm*) RegionRealloc(terms,
+                                                  sizeof(LeafTerm) * capacity,
+                                                  sizeof(LeafTerm) * capacity * 2);
+                capacity *= 2;
+            }
+            terms[length].exp = heap[0].exp;
+            terms[length++].coeff = (poly_coeff_t) c;
+        }
+        if (++heap[0].col.k < b->count) {
+            heap[0].exp = exps_a[heap[0].row] + exps_b[heap[0].col.k];
+        }
+        else {
+            heap[0] = heap[--size];
+        }
+        MulHeapSiftDown(heap, size);
+    }
+    if (length > 0 && terms[length - 1].coeff == 0) {
+        length--;
+    }
+    if (length == 0) {
+        RegionRestore(mark);
+        return PolyZero();
+    }
+    product = LeafNew(length);
+    for (unsigned i = 0; i < length; i++) {
+        product->coeffs[i] = terms[i].coeff;
+        LeafExps(product)[i] = terms[i].exp;
+    }
+    RegionRestore(mark);
+    return LeafFinish(product, length);
+}
+
+/**
+ * Mnoży wielomiany, z których co najmniej jeden jest liściem,
+ * pomocnicza funkcja dla PolyMul.
+ * @param[in] p : wielomian
+ * @param[in] q : wielomian
+ * @return `p * q`
+ */
+static Poly PolyMulLeaf(const Poly *p, const Poly *q)
+{
+    Poly expanded, product;
+
+    if (p->tag != LEAF) {
+        return PolyMulLeaf(q, p);
+    }
+    else if (q->tag == LEAF) {
+        return LeafMul(p->type.l, q->type.l);
+    }
+    else if (PolyIsCoeff(q)) {
+        return LeafScale(p->type.l, q->type.c);
+    }
+    else {
+        expanded = LeafExpand(p);
+        product = PolyMul(&expanded, q);
+        PolyDestroy(&expanded);
+        return product;
+    }
+}
+
+Poly PolyMul(const Poly *p, const Poly *q)
+{
+    Poly score;
+
+    if (PolyIsZero(p) || PolyIsZero(q)) {
+        return PolyZero();
+    }
+    else if (PolyIsCoeff(p) || PolyIsCoeff(q)) {
+        if (PolyIsCoeff(p) && PolyIsCoeff(q)) {
+            return PolyFromCoeff((poly_coeff_t) ((unsigned long) p->type.c *
+                                                 (unsigned long) q->type.c));
+        }
+        else if (PolyIsCoeff(p)) {
+            return PolyMulScalar(q, p->type.c);
+        }
+        else {
+            return PolyMulScalar(p, q->type.c);
+        }
+    }
+    else if (p->tag == LEAF || q->tag == LEAF) {
+        return PolyInterned(PolyMulLeaf(p, q));
+    }
+    else if (PolyMulKronecker(p, q, &score)) {
+        return score;
+    }
+    else {
+        return PolyMulHeap(p, q);
+    }
+}
+
+Poly PolySqr(const Poly *p)
+{
+    Poly square;
+
+    if (PolyIsCoeff(p)) {
+        return PolyFromCoeff((poly_coeff_t) ((unsigned long) p->type.c *
+                                             (unsigned long) p->type.c));
+    }
+    else if (p->tag == LEAF) {
+        return PolyInterned(LeafMul(p->type.l, p->type.l));
+    }
+    else if (PolyMulKronecker(p, p, &square)) {
+        return square;
+    }
+    else {
+        return PolySqrHeap(p);
+    }
+}
@@ -0,0 +1,247 @@
+/** @file
+   Odroczone zwalnianie pamięci: wątek tła zwalnia poziomy usuwanych
+   wielomianów, a wątek główny tylko wkłada je do kolejki
+
+   @author Piotr Szuberski <p.szuberski@student.uw.edu.pl>,
+   @copyright Uniwersytet Warszawski
+   @date 2026-10-18,
+*/
+
+#include <stdlib.h>
+#include <pthread.h>
+#include "utils.h"
+#include "mem_pool.h"
+#include "poly_internal.h"
+
+/** Początkowa pojemność tablicy referencji oddanych wątkowi głównemu */
+#define RECLAIM_RETURNED_START 16
+
+/**
+ * Stan odroczonego zwalniania pamięci. Wątek główny zwalnia referencję
+ * do korzenia i, jeśli była ostatnia, wkłada poziom do ograniczonej kolejki;
+ * wątek tła zwalnia poziomy, do których odwołuje się tylko zwalniany
+ * wielomian, a współdzielone współczynniki oddaje wątkowi głównemu,
+ * który jako jedyny zmienia liczniki referencji współdzielonych poziomów.
+ */
+static struct {
+    bool stop; /**< stop : czy wątek tła ma się zakończyć */
+    bool busy; /**< busy : czy wątek tła zwalnia właśnie poziom */
+    pthread_t thread; /**< thread : wątek tła */
+    pthread_mutex_t lock; /**< lock : chroni pozostałe pola */
+    pthread_cond_t not_empty; /**< not_empty : w kolejce pojawił się poziom */
+    pthread_cond_t not_full; /**< not_full : w kolejce zwolniło się miejsce */
+    pthread_cond_t idle; /**< idle : kolejka jest pusta, a wątek bezczynny */
+    Poly *queue; /**< queue : bufor cykliczny poziomów do zwolnienia */
+    size_t capacity; /**< capacity : pojemność kolejki */
+    size_t first; /**< first : indeks najstarszego poziomu w kolejce */
+    size_t size; /**< size : liczba poziomów w kolejce */
+    Poly *returned; /**< returned : referencje oddane wątkowi głównemu */
+    size_t returned_size; /**< returned_size : liczba oddanych referencji */
+    size_t returned_capacity; /**< returned_capacity : pojemność returned */
+} reclaim = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .not_empty = PTHREAD_COND_INITIALIZER,
+    .not_full = PTHREAD_COND_INITIALIZER,
+    .idle = PTHREAD_COND_INITIALIZER
+};
+
+bool reclaim_active = false;
+
+/**
+ * Oddaje wątkowi głównemu referencję do współdzielonego poziomu.
+ * @param[in] level : wielomian
+ */
+static void ReclaimHandBack(Poly level)
+{
+    pthread_mutex_lock(&reclaim.lock);
+    if (reclaim.returned_size == reclaim.returned_capacity) {
+        reclaim.returned_capacity = reclaim.returned_capacity == 0 ?
+                                    RECLAIM_RETURNED_START :
+                                    2 * reclaim.returned_capacity;
+        reclaim.returned = (Poly*) realloc(reclaim.returned, sizeof(Poly) *
+                                           reclaim.returned_capacity);
+        assert(reclaim.returned != NULL);
+    }
+    reclaim.returned[reclaim.returned_size++] = level;
+    pthread_mutex_unlock(&reclaim.lock);
+}
+
+void PolyFreeLevels(Poly level, bool background)
+{
+    WorkStack pending;
+    Mono *m, *next;
+    Poly coeff;
+    unsigned count;
+    bool owned = background;
+    void (*release)(void *, size_t) = background ? MemPoolFreeRemote
+                                                 : MemPoolFree;
+
+    WorkStackInit(&pending, sizeof(Poly));
+    do {
+        if (owned) {
+            owned = false;
+        }
+        else if (background) {
+            if (__atomic_load_n(PolyRefs(&level), __ATOMIC_ACQUIRE) != 1) {
+                ReclaimHandBack(level);
+                continue;
+            }
+        }
+        else if (level.tag == LEAF ? RefsRelease(&level.type.l->refs) != 0
+                                   : !MonoRelease(level.type.m)) {
+            continue;
+        }
+        if (level.tag == LEAF) {
+            release(level.type.l, LeafSize(level.type.l->count));
+            continue;
+        }
+        count = 0;
+        for (m = level.type.m; m != NULL; m = next) {
+            next = MonoNext(m);
+            coeff = MonoGetPoly(m);
+            if (!PolyIsCoeff(&coeff) && !PolyIsZero(&coeff)) {
+                WorkStackPush(&pending, &coeff);
+            }
+            if (level.tag != ARRAY) {
+                release(m, sizeof(Mono));
+            }
+            count++;
+        }
+        if (level.tag == ARRAY) {
+            release(level.type.m, sizeof(Mono) * count);
+        }
+    } while (WorkStackPop(&pending, &level));
+    WorkStackFree(&pending);
+}
+
+void ReclaimRelease(Poly level)
+{
+    Poly *returned = NULL;
+    size_t count = 0, i = 0;
+
+    while (true) {
+        if (level.tag == LEAF ? RefsRelease(&level.type.l->refs) == 0
+                              : MonoRelease(level.type.m)) {
+            pthread_mutex_lock(&reclaim.lock);
+            while (reclaim.size == reclaim.capacity) {
+                pthread_cond_wait(&reclaim.not_full, &reclaim.lock);
+            }
+            reclaim.queue[(reclaim.first + reclaim.size) % reclaim.capacity] =
+                level;
+            reclaim.size++;
+            pthread_cond_signal(&reclaim.not_empty);
+            if (i == count) {
+                free(returned);
+                returned = reclaim.returned;
+                count = reclaim.returned_size;
+                i = 0;
+                reclaim.returned = NULL;
+                reclaim.returned_size = 0;
+                reclaim.returned_capacity = 0;
+            }
+            pthread_mutex_unlock(&reclaim.lock);
+        }
+        if (i == count) {
+            break;
+        }
+        level = returned[i++];
+    }
+    free(returned);
+}
+
+/**
+ * Główna pętla wątku tła.
+ * @param[in] arg : nieużywany
+ * @return NULL
+ */
+static void *ReclaimMain(void *arg)
+{
+    Poly level;
+
+    (void) arg;
+    pthread_mutex_lock(&reclaim.lock);
+    while (true) {
+        while (reclaim.size == 0 && !reclaim.stop) {
+            pthread_cond_wait(&reclaim.not_empty, &reclaim.lock);
+        }
+        if (reclaim.size == 0) {
+            break;
+        }
+        level = reclaim.queue[reclaim.first];
+        reclaim.first = (reclaim.first + 1) % reclaim.capacity;
+        reclaim.size--;
+        reclaim.busy = true;
+        pthread_cond_signal(&reclaim.not_full);
+        pthread_mutex_unlock(&reclaim.lock);
+        PolyFreeLevels(level, true);
+        pthread_mutex_lock(&reclaim.lock);
+        reclaim.busy = false;
+        if (reclaim.size == 0) {
+            pthread_cond_broadcast(&reclaim.idle);
+        }
+    }
+    pthread_mutex_unlock(&reclaim.lock);
+    return NULL;
+}
+
+bool PolyReclaimStart(size_t capacity)
+{
+    if (reclaim_active || capacity == 0) {
+        return reclaim_active;
+    }
+    reclaim.queue = (Poly*) malloc(sizeof(Poly) * capacity);
+    assert(reclaim.queue != NULL);
+    reclaim.capacity = capacity;
+    reclaim.first = 0;
+    reclaim.size = 0;
+    reclaim.stop = false;
+    if (pthread_create(&reclaim.thread, NULL, ReclaimMain, NULL) != 0) {
+        free(reclaim.queue);
+        reclaim.queue = NULL;
+        return false;
+    }
+    reclaim_active = true;
+    return true;
+}
+
+void PolyReclaimDrain(void)
+{
+    Poly *returned;
+    size_t count;
+
+    if (!reclaim_active) {
+        return;
+    }
+    do {
+        pthread_mutex_lock(&reclaim.lock);
+        while (reclaim.size > 0 || reclaim.busy) {
+            pthread_cond_wait(&reclaim.idle, &reclaim.lock);
+        }
+        returned = reclaim.returned;
+        count = reclaim.returned_size;
+        reclaim.returned = NULL;
+        reclaim.returned_size = 0;
+        reclaim.returned_capacity = 0;
+        pthread_mutex_unlock(&reclaim.lock);
+        for (size_t i = 0; i < count; i++) {
+            ReclaimRelease(returned[i]);
+        }
+        free(returned);
+    } while (count > 0);
+}
+
+void PolyReclaimStop(void)
+{
+    if (!reclaim_active) {
+        return;
+    }
+    PolyReclaimDrain();
+    pthread_mutex_lock(&reclaim.lock);
+    reclaim.stop = true;
+    pthread_cond_signal(&reclaim.not_empty);
+    pthread_mutex_unlock(&reclaim.lock);
+    pthread_join(reclaim.thread, NULL);
+    reclaim_active = false;
+    free(reclaim.queue);
+    reclaim.queue = NULL;
+}
@@ -0,0 +1,162 @@
+/** @file
+   Progi wyboru algorytmu mnożenia: wartości domyślne, zmiana progów
+   i plik progów zapisywany przez autotune_poly
+
+   @author Piotr Szuberski <p.szuberski@student.uw.edu.pl>,
+   @copyright Uniwersytet Warszawski
+   @date 2026-10-18,
+*/
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "poly_internal.h"
+
+/** Domyślna największa długość tablicy współczynników iloczynu po
+ * podstawieniu */
+#define KRONECKER_MAX_SPAN (1u << 20)
+
+/** Domyślna najmniejsza liczba iloczynów jednomianów, od której opłaca się
+ * podstawienie Kroneckera */
+#define KRONECKER_MIN_PRODUCTS 256
+
+/** Domyślnie ile razy tablica współczynników iloczynu może być dłuższa od
+ * liczby iloczynów jednomianów, żeby podstawienie się opłacało */
+#define KRONECKER_SPARSITY 8
+
+/** Domyślna długość, poniżej której Karatsuba przechodzi na mnożenie
+ * szkolne */
+#define KARATSUBA_CUTOFF 32
+
+/** Domyślnie ile razy rozpiętość wykładników czynnika może przekraczać
+ * liczbę jego jednomianów, żeby czynnik był uznany za gęsty */
+#define KARATSUBA_DENSITY 4
+
+/** Domyślna długość krótszego czynnika, od której gęste iloczyny liczone
+ * są transformatą teorioliczbową (NttMul) zamiast metodą Karatsuby, gdy
+ * wystarcza jedna liczba pierwsza */
+#define NTT_THRESHOLD 2048
+
+/** Domyślnie ile razy rośnie próg ntt_threshold z każdą kolejną liczbą
+ * pierwszą */
+#define NTT_PRIME_FACTOR 5
+
+/** Domyślna najmniejsza liczba punktów i długość liścia, od których
+ * PolyAtMany wartościuje przez drzewo podiloczynów */
+#define MULTIPOINT_THRESHOLD 65536
+
+/** Domyślne progi wyboru algorytmu mnożenia */
+#define MUL_TUNING_DEFAULTS { \
+    KARATSUBA_CUTOFF, KARATSUBA_DENSITY, NTT_THRESHOLD, NTT_PRIME_FACTOR, \
+    KRONECKER_MIN_PRODUCTS, KRONECKER_MAX_SPAN, KRONECKER_SPARSITY, \
+    MULTIPOINT_THRESHOLD \
+}
+
+PolyMulTuning mul_tuning = MUL_TUNING_DEFAULTS;
+
+/**
+ * Nazwa pola PolyMulTuning w pliku progów
+ */
+typedef struct MulTuningKey {
+    const char *name; /**< name : nazwa pola */
+    size_t offset; /**< offset : przesunięcie pola w PolyMulTuning */
+} MulTuningKey;
+
+/** Pola PolyMulTuning zapisywane w pliku progów */
+static const MulTuningKey mul_tuning_keys[] = {
+    {"karatsuba_cutoff", offsetof(PolyMulTuning, karatsuba_cutoff)},
+    {"karatsuba_density", offsetof(PolyMulTuning, karatsuba_density)},
+    {"ntt_threshold", offsetof(PolyMulTuning, ntt_threshold)},
+    {"ntt_prime_factor", offsetof(PolyMulTuning, ntt_prime_factor)},
+    {"kronecker_min_products",
+        offsetof(PolyMulTuning, kronecker_min_products)},
+    {"kronecker_max_span", offsetof(PolyMulTuning, kronecker_max_span)},
+    {"kronecker_sparsity", offsetof(PolyMulTuning, kronecker_sparsity)},
+    {"multipoint_threshold", offsetof(PolyMulTuning, multipoint_threshold)}
+};
+
+/** Liczba pól PolyMulTuning zapisywanych w pliku progów */
+#define MUL_TUNING_KEYS (sizeof(mul_tuning_keys) / sizeof(mul_tuning_keys[0]))
+
+/** Największa długość nazwy pola i wartości w pliku progów */
+#define MUL_TUNING_NAME 64
+
+/** Największa długość wiersza pliku progów */
+#define MUL_TUNING_LINE 256
+
+PolyMulTuning PolyMulGetTuning(void)
+{
+    return mul_tuning;
+}
+
+void PolyMulSetTuning(const PolyMulTuning *tuning)
+{
+    static const PolyMulTuning defaults = MUL_TUNING_DEFAULTS;
+    size_t *field;
+
+    mul_tuning = *tuning;
+    for (size_t i = 0; i < MUL_TUNING_KEYS; i++) {
+        field = (size_t*) ((char*) &mul_tuning + mul_tuning_keys[i].offset);
+        if (*field == 0) {
+            *field = *(const size_t*) ((const char*) &defaults +
+                                       mul_tuning_keys[i].offset);
+        }
+    }
+    /* rozmiar tablicy współczynników w bajtach musi mieścić się w size_t */
+    if (mul_tuning.kronecker_max_span > SIZE_MAX / sizeof(poly_coeff_t)) {
+        mul_tuning.kronecker_max_span = SIZE_MAX / sizeof(poly_coeff_t);
+    }
+}
+
+bool PolyMulLoadTuning(const char *path)
+{
+    PolyMulTuning tuning = MUL_TUNING_DEFAULTS;
+    char line[MUL_TUNING_LINE], name[MUL_TUNING_NAME];
+    char digits[MUL_TUNING_NAME], extra, *end;
+    unsigned long long value;
+    FILE *file = fopen(path, "r");
+
+    if (file == NULL) {
+        return false;
+    }
+    while (fgets(line, sizeof(line), file) != NULL) {
+        if (sscanf(line, "%63s %63s %c", name, digits, &extra) != 2 ||
+            !isdigit((unsigned char) digits[0])) {
+            continue;
+        }
+        errno = 0;
+        value = strtoull(digits, &end, 10);
+        if (*end != '\0' || errno == ERANGE || value > SIZE_MAX) {
+            continue;
+        }
+        for (size_t i = 0; i < MUL_TUNING_KEYS; i++) {
+            if (strcmp(name, mul_tuning_keys[i].name) == 0) {
+                *(size_t*) ((char*) &tuning + mul_tuning_keys[i].offset) =
+                    (size_t) value;
+            }
+        }
+    }
+    fclose(file);
+    PolyMulSetTuning(&tuning);
+    return true;
+}
+
+bool PolyMulSaveTuning(const char *path)
+{
+    FILE *file = fopen(path, "w");
+    bool written = true;
+
+    if (file == NULL) {
+        return false;
+    }
+    for (size_t i = 0; i < MUL_TUNING_KEYS; i++) {
+        written &= fprintf(file, "%s %zu\n", mul_tuning_keys[i].name,
+                           *(const size_t*) ((const char*) &mul_tuning +
+                                             mul_tuning_keys[i].offset)) > 0;
+    }
+    return fclose(file) == 0 && written;
+}
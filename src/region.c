@@ -0,0 +1,168 @@
+/** @file
+   Region pamięci dla obiektów tymczasowych
+
+   @author Piotr Szuberski <p.szuberski@student.uw.edu.pl>,
+   @copyright Uniwersytet Warszawski
+   @date 2026-10-18,
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include "utils.h"
+#include "region.h"
+
+/** Wyrównanie obiektów przydzielanych z regionu */
+#define REGION_ALIGN _Alignof(max_align_t)
+
+/**
+ * Blok regionu, bloki w użyciu tworzą stos
+ */
+typedef struct RegionChunk {
+    struct RegionChunk *prev; /**< prev : poprzedni blok regionu */
+    size_t size; /**< size : pojemność bloku w bajtach */
+    size_t used; /**< used : liczba zajętych bajtów bloku */
+    _Alignas(max_align_t) unsigned char data[]; /**< data : obiekty */
+} RegionChunk;
+
+/** Pojemność bloku o domyślnym rozmiarze */
+#define REGION_CHUNK_DATA (REGION_CHUNK_SIZE - offsetof(RegionChunk, data))
+
+/** Bieżący blok regionu */
+static RegionChunk *region_current;
+
+/** Lista zwolnionych bloków o domyślnym rozmiarze */
+static RegionChunk *region_spare;
+
+/**
+ * Zaokrągla rozmiar obiektu w górę do wielokrotności wyrównania
+ * @param[in] size : rozmiar obiektu
+ * @return zaokrąglony rozmiar
+ */
+static inline size_t RegionRound(size_t size)
+{
+    return size == 0 ? REGION_ALIGN :
+           (size + REGION_ALIGN - 1) & ~(REGION_ALIGN - 1);
+}
+
+/**
+ * Kładzie na stos bloków nowy blok mieszczący co najmniej @p size bajtów
+ * @param[in] size : rozmiar przydzielanego obiektu
+ */
+static void RegionGrow(size_t size)
+{
+    RegionChunk *chunk;
+
+    if (size <= REGION_CHUNK_DATA && region_spare != NULL) {
+        chunk = region_spare;
+        region_spare = chunk->prev;
+    }
+    else {
+        if (size < REGION_CHUNK_DATA) {
+            size = REGION_CHUNK_DATA;
+        }
+        chunk = (RegionChunk*) malloc(offsetof(RegionChunk, data) + size);
+        assert(chunk != NULL);
+        chunk->size = size;
+    }
+    chunk->prev = region_current;
+    chunk->used = 0;
+    region_current = chunk;
+}
+
+/**
+ * Zdejmuje blok ze stosu bloków; blok o domyślnym rozmiarze trafia na listę
+ * zwolnionych bloków, pozostałe są zwalniane
+ * @param[in] chunk : zdejmowany blok
+ */
+static void RegionDiscard(RegionChunk *chunk)
+{
+#ifndef UNIT_TESTING
+    if (chunk->size == REGION_CHUNK_DATA) {
+        chunk->prev = region_spare;
+        region_spare = chunk;
+        return;
+    }
+#endif /* UNIT_TESTING */
+    free(chunk);
+}
+
+void *RegionAlloc(size_t size)
+{
+    void *ptr;
+
+    size = RegionRound(size);
+    if (region_current == NULL ||
+        region_current->size - region_current->used < size) {
+        RegionGrow(size);
+    }
+    ptr = region_current->data + region_current->used;
+    region_current->used += size;
+    return ptr;
+}
+
+void *RegionRealloc(void *ptr, size_t old_size, size_t new_size)
+{
+    size_t offset;
+    void *moved;
+
+    if (ptr == NULL) {
+        return RegionAlloc(new_size);
+    }
+    if (new_size <= old_size) {
+        return ptr;
+    }
+    offset = (size_t) ((uintptr_t) ptr - (uintptr_t) region_current->data);
+    if (offset < region_current->used &&
+        offset + RegionRound(old_size) == region_current->used &&
+        offset + RegionRound(new_size) <= region_current->size) {
+        region_current->used = offset + RegionRound(new_size);
+        return ptr;
+    }
+    moved = RegionAlloc(new_size);
+    memcpy(moved, ptr, old_size);
+    return moved;
+}
+
+RegionMark RegionSave(void)
+{
+    RegionMark mark;
+
+    mark.chunk = region_current;
+    mark.used = region_current != NULL ? region_current->used : 0;
+    return mark;
+}
+
+void RegionRestore(RegionMark mark)
+{
+    RegionChunk *chunk;
+
+    while (region_current != mark.chunk) {
+        chunk = region_current;
+        region_current = chunk->prev;
+        RegionDiscard(chunk);
+    }
+    if (region_current != NULL) {
+        region_current->used = mark.used;
+    }
+}
+
+void RegionReset(void)
+{
+    RegionMark empty = {NULL, 0};
+
+    RegionRestore(empty);
+}
+
+void RegionReleaseAll(void)
+{
+    RegionChunk *chunk;
+
+    RegionReset();
+    while (region_spare != NULL) {
+        chunk = region_spare;
+        region_spare = chunk->prev;
+        free(chunk);
+    }
+}
@@ -0,0 +1,75 @@
+/** @file
+   Interfejs regionu pamięci dla obiektów tymczasowych
+
+   Region przydziela pamięć przesuwając wskaźnik w bieżącym bloku, bez
+   zwalniania pojedynczych obiektów. Funkcja RegionSave zapamiętuje stan
+   regionu, a RegionRestore zwalnia naraz wszystko, co przydzielono od
+   zapamiętanego stanu, więc przydziały i zwolnienia muszą być zagnieżdżone
+   jak na stosie. Kalkulator czyści region po każdym poleceniu funkcją
+   RegionReset. Zwolnione bloki są zachowywane do ponownego użycia, aż do
+   wywołania RegionReleaseAll.
+   Region należy do jednego wątku.
+
+   @author Piotr Szuberski <p.szuberski@student.uw.edu.pl>,
+   @copyright Uniwersytet Warszawski
+   @date 2026-10-18,
+*/
+
+#ifndef WIELOMIANY_REGION_H
+#define WIELOMIANY_REGION_H
+
+#include <stddef.h>
+
+/** Rozmiar pojedynczego bloku regionu w bajtach */
+#define REGION_CHUNK_SIZE (64 * 1024)
+
+/**
+ * Stan regionu zapamiętany przez RegionSave
+ */
+typedef struct RegionMark {
+    struct RegionChunk *chunk; /**< chunk : bieżący blok regionu */
+    size_t used; /**< used : liczba zajętych bajtów bieżącego bloku */
+} RegionMark;
+
+/**
+ * Przydziela z regionu obiekt o rozmiarze @p size.
+ * @param[in] size : rozmiar obiektu w bajtach
+ * @return wskaźnik na przydzieloną pamięć
+ */
+void *RegionAlloc(size_t size);
+
+/**
+ * Zmienia rozmiar obiektu przydzielonego z regionu. Ostatni przydzielony
+ * obiekt jest powiększany w miejscu, o ile mieści się w bieżącym bloku,
+ * pozostałe są kopiowane.
+ * @param[in] ptr : obiekt z regionu lub NULL
+ * @param[in] old_size : dotychczasowy rozmiar obiektu w bajtach
+ * @param[in] new_size : nowy rozmiar obiektu w bajtach
+ * @return wskaźnik na obiekt o nowym rozmiarze
+ */
+void *RegionRealloc(void *ptr, size_t old_size, size_t new_size);
+
+/**
+ * Zapamiętuje bieżący stan regionu.
+ * @return stan regionu
+ */
+RegionMark RegionSave(void);
+
+/**
+ * Zwalnia wszystkie obiekty przydzielone od zapamiętania stanu @p mark.
+ * @param[in] mark : stan regionu zwrócony przez RegionSave
+ */
+void RegionRestore(RegionMark mark);
+
+/**
+ * Zwalnia wszystkie obiekty regionu, zachowując bloki do ponownego użycia.
+ */
+void RegionReset(void);
+
+/**
+ * Zwalnia wszystkie bloki regionu. Wolno ją wywołać tylko wtedy, gdy żaden
+ * obiekt przydzielony z regionu nie jest już używany.
+ */
+void RegionReleaseAll(void);
+
+#endif //WIELOMIANY_REGION_H
@@ -1,6 +1,6 @@
 /** @file
-   Testy jednostkowe z użyciem biblioteki cmocka do funkcji PolyCompose
-   z biblioteki poly.c i COMPOSE z kalkulatora wielomianów wielu zmiennych
+   Testy jednostkowe z użyciem biblioteki cmocka do funkcji biblioteki
+   poly.c i poleceń kalkulatora wielomianów wielu zmiennych
 
    @author Piotr Szuberski <p.szuberski@student.uw.edu.pl>,
    @copyright Uniwersytet Warszawski
@@ -10,10 +10,15 @@
 
 #include <limits.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <string.h>
 #include <setjmp.h>
 #include "cmocka.h"
 #include "calc_poly.h"
+#include "batch_eval.h"
+#include "mem_pool.h"
+#include "region.h"
+#include "ntt.h"
 
 /**
  * podstawiona main z calc_poly
@@ -459,9 +464,1565 @@ static void compose_digits_and_letters_test(void **state) {
     assert_string_equal(fprintf_buffer, expected);
 }
 
+/**
+ * Test PolyMemStats: klon współdzieli poziomy z oryginałem, więc dla obu
+ * wielomianów liczone są raz, a rozmiar w bajtach zgadza się z pamięcią
+ * przydzieloną z puli
+ * @param[in] state : nieużywany
+ */
+static void mem_stats_shared_test(void **state) {
+    (void) state;
+
+    MemPoolStats before = MemPoolGetStats(), after;
+    Poly inner, p, pair[2];
+    Poly a = create_p_poly(1, 2), b = create_p_poly(3, 4);
+    Mono m;
+    PolyMemInfo one, both;
+
+    inner = PolyAdd(&a, &b); /* inner = x^2 + 3x^4 */
+    PolyDestroy(&a);
+    PolyDestroy(&b);
+    m = MonoFromPoly(&inner, 1);
+    p = PolyAddMonos(1, &m); /* p = (x_1^2 + 3x_1^4)x_0 */
+    pair[0] = p;
+    pair[1] = PolyClone(&p);
+
+    one = PolyMemStats(&p);
+    both = PolyMemStatsMany(2, pair);
+    after = MemPoolGetStats();
+
+    assert_int_equal(one.nodes, 3);
+    assert_int_equal(one.depth, 2);
+    assert_int_equal(one.leaves, 1);
+    assert_int_equal(both.nodes, one.nodes);
+    assert_int_equal(both.leaves, one.leaves);
+    assert_int_equal(both.bytes, one.bytes);
+    assert_int_equal(both.bytes, after.live_bytes - before.live_bytes);
+
+    PolyDestroy(&pair[0]);
+    PolyDestroy(&pair[1]);
+}
+
+/**
+ * Test PolyMemStats z poziomem współdzielonym przez dwa współczynniki
+ * jednego wielomianu
+ * @param[in] state : nieużywany
+ */
+static void mem_stats_shared_coeff_test(void **state) {
+    (void) state;
+
+    MemPoolStats before = MemPoolGetStats(), after;
+    Poly inner = create_p_poly(5, 3), p;
+    Mono monos[2];
+    PolyMemInfo info;
+
+    monos[0] = MonoFromPoly(&inner, 1);
+    inner = PolyClone(&inner);
+    monos[1] = MonoFromPoly(&inner, 2);
+    p = PolyAddMonos(2, monos); /* p = 5x_1^3 x_0 + 5x_1^3 x_0^2 */
+
+    info = PolyMemStats(&p);
+    after = MemPoolGetStats();
+
+    assert_int_equal(info.nodes, 3);
+    assert_int_equal(info.depth, 2);
+    assert_int_equal(info.leaves, 1);
+    assert_int_equal(info.bytes, after.live_bytes - before.live_bytes);
+
+    PolyDestroy(&p);
+}
+
+/**
+ * Test MEM na pustym stosie: wypisuje sumę dla pustego stosu i liczniki
+ * puli zamiast błędu
+ * @param[in] state : nieużywany
+ */
+static void mem_empty_stack_test(void **state) {
+    (void) state;
+
+    char expected[] = "STACK polys=0 nodes=0 depth=0 leaves=0 bytes=0\n"
+                      "POOL live=";
+
+    strcpy(input_stream_buffer, "MEM\n");
+    input_stream_end = (int) strlen(input_stream_buffer);
+
+    mock_main();
+
+    assert_int_equal(strncmp(printf_buffer, expected, strlen(expected)), 0);
+    assert_string_equal(fprintf_buffer, "");
+}
+
+/**
+ * Pomocnicza funkcja do otrzymywania wielomianu w formie p x_0^e
+ * @param[in] p : współczynnik, przejmowany na własność
+ * @param[in] e : wykładnik
+ * @return p x_0^e
+ */
+static Poly create_nested_poly(Poly p, int e)
+{
+    Mono tmp = MonoFromPoly(&p, e);
+
+    return PolyAddMonos(1, &tmp);
+}
+
+/**
+ * Pomocnicza funkcja budująca te same wielomiany przy włączonym
+ * i wyłączonym internowaniu
+ * @param[out] out : suma, jej kwadrat i różnica kwadratu i iloczynu
+ */
+static void build_intern_polys(Poly out[3])
+{
+    Poly a = create_p_poly(2, 3), b = create_p_poly(-1, 1), leaf, upper;
+    Poly lower;
+
+    leaf = PolyAdd(&a, &b); /* leaf = 2x^3 - x */
+    PolyDestroy(&a);
+    PolyDestroy(&b);
+    a = PolyClone(&leaf);
+    upper = create_nested_poly(leaf, 2);
+    lower = create_nested_poly(a, 0);
+    out[0] = PolyAdd(&upper, &lower); /* (2x_1^3 - x_1)(x_0^2 + 1) */
+    PolyDestroy(&upper);
+    PolyDestroy(&lower);
+    out[1] = PolyMul(&out[0], &out[0]);
+    out[2] = PolySub(&out[1], &out[1]);
+}
+
+/**
+ * Test internowania: IS_EQ, DEG i PRINT dają te same wyniki dla
+ * wielomianów zbudowanych przy włączonym i wyłączonym internowaniu, a
+ * równe poziomy zbudowane osobno są współdzielone
+ * @param[in] state : nieużywany
+ */
+static void intern_keeps_results_test(void **state) {
+    (void) state;
+
+    Poly plain[3], interned[3], again[3];
+    int printed;
+
+    build_intern_polys(plain);
+    PolyInternEnable(true);
+    build_intern_polys(interned);
+    build_intern_polys(again);
+    PolyInternEnable(false);
+
+    for (int i = 0; i < 3; i++) {
+        assert_true(PolyIsEq(&plain[i], &interned[i]));
+        assert_true(PolyIsEq(&interned[i], &again[i]));
+        assert_int_equal(PolyDeg(&plain[i]), PolyDeg(&interned[i]));
+        assert_int_equal(PolyDegBy(&plain[i], 1),
+                         PolyDegBy(&interned[i], 1));
+    }
+    assert_false(PolyIsEq(&interned[0], &interned[1]));
+    assert_true(PolyIsZero(&interned[2]));
+    assert_ptr_equal(interned[1].type.m, again[1].type.m);
+    assert_true(PolyInternGetStats().hits > 0);
+
+    PolyPrint(&plain[1]);
+    printed = printf_position;
+    PolyPrint(&interned[1]);
+    assert_int_equal(printf_position, 2 * printed);
+    assert_int_equal(memcmp(printf_buffer, printf_buffer + printed,
+                            (size_t) printed), 0);
+
+    for (int i = 0; i < 3; i++) {
+        PolyDestroy(&plain[i]);
+        PolyDestroy(&interned[i]);
+        PolyDestroy(&again[i]);
+    }
+    PolyInternClear();
+}
+
+/**
+ * Test powiększania tablicy internowania: łańcuch poziomów, do których
+ * nie ma już referencji spoza tablicy, jest z niej usuwany w całości
+ * @param[in] state : nieużywany
+ */
+static void intern_grow_releases_chain_test(void **state) {
+    (void) state;
+
+    Poly chain;
+
+    PolyInternEnable(true);
+    chain = PolyFromCoeff(1);
+    for (int i = 0; i < 400; i++) {
+        chain = create_nested_poly(chain, 1);
+    }
+    PolyDestroy(&chain);
+    chain = PolyFromCoeff(2);
+    for (int i = 0; i < 400; i++) {
+        chain = create_nested_poly(chain, 1);
+    }
+    PolyInternEnable(false);
+
+    assert_true(PolyInternGetStats().levels <= 400);
+    assert_int_equal(PolyDeg(&chain), 400);
+
+    PolyDestroy(&chain);
+    PolyInternClear();
+}
+
+/**
+ * Test odroczonego zwalniania: po usunięciu wielomianów i opróżnieniu
+ * kolejki pamięć puli w użyciu wraca do stanu sprzed ich utworzenia,
+ * a klon usuniętego wielomianu pozostaje poprawny
+ * @param[in] state : nieużywany
+ */
+static void reclaim_drain_test(void **state) {
+    (void) state;
+
+    MemPoolStats before = MemPoolGetStats();
+    Poly polys[3], model[3], kept;
+
+    build_intern_polys(polys);
+    build_intern_polys(model);
+    kept = PolyClone(&polys[1]);
+    assert_true(PolyReclaimStart(2));
+
+    for (int i = 0; i < 3; i++) {
+        PolyDestroy(&polys[i]);
+    }
+    PolyReclaimDrain();
+    assert_true(PolyIsEq(&kept, &model[1]));
+
+    PolyDestroy(&kept);
+    for (int i = 0; i < 3; i++) {
+        PolyDestroy(&model[i]);
+    }
+    PolyReclaimDrain();
+    assert_int_equal(MemPoolGetStats().live_bytes, before.live_bytes);
+
+    PolyReclaimStop();
+}
+
+/**
+ * Test zatrzymania odroczonego zwalniania: po PolyReclaimStop
+ * PolyDestroy zwalnia pamięć od razu
+ * @param[in] state : nieużywany
+ */
+static void reclaim_stop_then_destroy_test(void **state) {
+    (void) state;
+
+    MemPoolStats before = MemPoolGetStats();
+    Poly polys[3];
+
+    assert_true(PolyReclaimStart(16));
+    PolyReclaimStop();
+
+    build_intern_polys(polys);
+    assert_true(MemPoolGetStats().live_bytes > before.live_bytes);
+    for (int i = 0; i < 3; i++) {
+        PolyDestroy(&polys[i]);
+    }
+    assert_int_equal(MemPoolGetStats().live_bytes, before.live_bytes);
+}
+
+/**
+ * Test zagnieżdżonych RegionSave i RegionRestore: przywrócenie stanu
+ * zwalnia tylko obiekty przydzielone po nim, a kolejne przydziały
+ * dostają tę samą pamięć
+ * @param[in] state : nieużywany
+ */
+static void region_nested_save_restore_test(void **state) {
+    (void) state;
+
+    RegionMark outer, middle, inner;
+    char *base, *a, *b, *c;
+
+    base = (char*) RegionAlloc(8);
+    outer = RegionSave();
+    a = (char*) RegionAlloc(100);
+    memset(a, 'a', 100);
+    middle = RegionSave();
+    b = (char*) RegionAlloc(200);
+    memset(b, 'b', 200);
+    inner = RegionSave();
+    c = (char*) RegionAlloc(50);
+    memset(c, 'c', 50);
+
+    RegionRestore(inner);
+    assert_ptr_equal(RegionAlloc(50), c);
+    RegionRestore(inner);
+    assert_true(b[0] == 'b' && b[199] == 'b');
+
+    RegionRestore(middle);
+    assert_ptr_equal(RegionAlloc(200), b);
+    RegionRestore(middle);
+    assert_true(a[0] == 'a' && a[99] == 'a');
+
+    RegionRestore(outer);
+    assert_ptr_equal(RegionAlloc(100), a);
+    assert_true(base < a);
+
+    RegionReleaseAll();
+}
+
+/**
+ * Test przydziałów niemieszczących się w bloku regionu: zwykły przydział
+ * przechodzi do nowego bloku, zbyt duży dostaje własny blok, a
+ * RegionRestore wraca do pierwszego bloku
+ * @param[in] state : nieużywany
+ */
+static void region_spill_test(void **state) {
+    (void) state;
+
+    RegionMark mark;
+    char *first, *spilled, *huge, *next, *grown;
+
+    first = (char*) RegionAlloc(REGION_CHUNK_SIZE / 2);
+    memset(first, 'f', REGION_CHUNK_SIZE / 2);
+    mark = RegionSave();
+
+    spilled = (char*) RegionAlloc(REGION_CHUNK_SIZE / 2 + 64);
+    assert_true(spilled < first || spilled >= first + REGION_CHUNK_SIZE);
+    memset(spilled, 's', REGION_CHUNK_SIZE / 2 + 64);
+    huge = (char*) RegionAlloc(3 * REGION_CHUNK_SIZE);
+    memset(huge, 'h', 3 * REGION_CHUNK_SIZE);
+    assert_true(spilled[0] == 's' && huge[3 * REGION_CHUNK_SIZE - 1] == 'h');
+
+    RegionRestore(mark);
+    next = (char*) RegionAlloc(16);
+    assert_ptr_equal(next, first + REGION_CHUNK_SIZE / 2);
+    assert_true(first[0] == 'f' && first[REGION_CHUNK_SIZE / 2 - 1] == 'f');
+
+    grown = (char*) RegionRealloc(next, 16, 64);
+    assert_ptr_equal(grown, next);
+    grown = (char*) RegionRealloc(first, REGION_CHUNK_SIZE / 2,
+                                  REGION_CHUNK_SIZE);
+    assert_true(grown != first);
+    assert_true(grown[0] == 'f' &&
+                grown[REGION_CHUNK_SIZE / 2 - 1] == 'f');
+
+    RegionReset();
+    RegionReleaseAll();
+}
+
+/** Największa liczba jednomianów jednego poziomu losowego wielomianu */
+#define RANDOM_MAX_TERMS 64
+
+/** Stan generatora liczb pseudolosowych testów mnożenia */
+static unsigned long long random_state = 88172645463325252ull;
+
+/**
+ * Generator xorshift, ten sam ciąg przy każdym uruchomieniu testów
+ * @return kolejna liczba pseudolosowa
+ */
+static unsigned long long random_next(void)
+{
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 7;
+    random_state ^= random_state << 17;
+    return random_state;
+}
+
+/**
+ * Losuje współczynnik o wartości bezwzględnej mniejszej niż 2^bits
+ * @param[in] bits : liczba bitów, 64 oznacza dowolną wartość long
+ * @return współczynnik
+ */
+static long random_coeff(unsigned bits)
+{
+    unsigned long long x = random_next();
+
+    if (bits >= 64) {
+        return (long) x;
+    }
+    return (long) (x % (2ull << (bits - 1))) - (long) ((1ull << (bits - 1)) - 1);
+}
+
+/**
+ * Losuje wielomian o zadanej liczbie zmiennych
+ * @param[in] vars : liczba zmiennych
+ * @param[in] terms : liczba jednomianów każdego poziomu
+ * @param[in] max_exp : największy wykładnik
+ * @param[in] bits : rozmiar współczynników, zob. random_coeff
+ * @return wielomian
+ */
+static Poly random_poly(unsigned vars, unsigned terms, poly_exp_t max_exp,
+                        unsigned bits)
+{
+    Mono monos[RANDOM_MAX_TERMS];
+    Poly coeff;
+
+    assert_true(terms <= RANDOM_MAX_TERMS);
+    if (vars == 0) {
+        return PolyFromCoeff(random_coeff(bits));
+    }
+    for (unsigned i = 0; i < terms; i++) {
+        coeff = random_poly(vars - 1, terms, max_exp, bits);
+        monos[i] = MonoFromPoly(&coeff, (poly_exp_t)
+                                (random_next() % ((unsigned) max_exp + 1)));
+    }
+    return PolyAddMonos(terms, monos);
+}
+
+/**
+ * Buduje wielomian jednej zmiennej o kolejnych wykładnikach
+ * @param[in] coeffs : współczynniki
+ * @param[in] count : liczba współczynników
+ * @param[in] first : wykładnik pierwszego współczynnika
+ * @return wielomian
+ */
+static Poly create_dense_poly(const long coeffs[], size_t count,
+                              poly_exp_t first)
+{
+    Mono *monos = (Mono*) malloc(sizeof(Mono) * count);
+    Poly coeff, p;
+
+    assert_non_null(monos);
+    for (size_t i = 0; i < count; i++) {
+        coeff = PolyFromCoeff(coeffs[i]);
+        monos[i] = MonoFromPoly(&coeff, first + (poly_exp_t) i);
+    }
+    p = PolyAddMonos((unsigned) count, monos);
+    free(monos);
+    return p;
+}
+
+/**
+ * Ustawia progi, przy których PolyMul nie wybiera żadnej szybkiej ścieżki:
+ * liście mnoży kopcem, a pozostałe wielomiany jak PolyMulHeap.
+ */
+static void set_reference_tuning(void)
+{
+    PolyMulTuning tuning;
+
+    memset(&tuning, 0, sizeof(tuning));
+    tuning.karatsuba_cutoff = SIZE_MAX;
+    tuning.ntt_threshold = SIZE_MAX;
+    tuning.kronecker_min_products = SIZE_MAX;
+    PolyMulSetTuning(&tuning);
+}
+
+/**
+ * Sprawdza, czy iloczyn przy zadanych progach jest równy iloczynowi
+ * wzorcowemu, zob. set_reference_tuning. Przywraca poprzednie progi.
+ * @param[in] p : wielomian
+ * @param[in] q : wielomian
+ * @param[in] fast : progi sprawdzanej ścieżki
+ */
+static void assert_mul_matches_reference(const Poly *p, const Poly *q,
+                                         const PolyMulTuning *fast)
+{
+    PolyMulTuning saved = PolyMulGetTuning();
+    Poly expected, product;
+
+    set_reference_tuning();
+    expected = PolyMul(p, q);
+    PolyMulSetTuning(fast);
+    product = PolyMul(p, q);
+    PolyMulSetTuning(&saved);
+
+    assert_true(PolyIsEq(&expected, &product));
+
+    PolyDestroy(&expected);
+    PolyDestroy(&product);
+}
+
+/**
+ * Zwraca progi wymuszające podstawienie Kroneckera
+ * @param[in] karatsuba_cutoff : próg Karatsuby, SIZE_MAX wyłącza mnożenie
+ * gęste
+ * @return progi
+ */
+static PolyMulTuning kronecker_tuning(size_t karatsuba_cutoff)
+{
+    PolyMulTuning tuning;
+
+    memset(&tuning, 0, sizeof(tuning));
+    tuning.karatsuba_cutoff = karatsuba_cutoff;
+    tuning.karatsuba_density = 64;
+    tuning.ntt_threshold = SIZE_MAX;
+    tuning.kronecker_min_products = 1;
+    tuning.kronecker_max_span = (size_t) 1 << 24;
+    tuning.kronecker_sparsity = SIZE_MAX;
+    return tuning;
+}
+
+/**
+ * Test iloczynów wielomianów wielu zmiennych przez podstawienie
+ * Kroneckera, z akumulacją rzadką i z mnożeniem gęstym
+ * @param[in] state : nieużywany
+ */
+static void kronecker_forced_test(void **state) {
+    (void) state;
+
+    PolyMulTuning sparse = kronecker_tuning(SIZE_MAX);
+    PolyMulTuning dense = kronecker_tuning(2);
+    Poly p, q;
+
+    for (unsigned vars = 2; vars <= 4; vars++) {
+        p = random_poly(vars, 3, 6, 20);
+        q = random_poly(vars, 4, 5, 64);
+        assert_mul_matches_reference(&p, &q, &sparse);
+        assert_mul_matches_reference(&p, &q, &dense);
+        assert_mul_matches_reference(&p, &p, &sparse);
+        assert_mul_matches_reference(&q, &q, &dense);
+        PolyDestroy(&p);
+        PolyDestroy(&q);
+    }
+}
+
+/**
+ * Test podstawienia Kroneckera, gdy upakowane wykładniki nie mieszczą się
+ * w size_t: PolyMul wraca do mnożenia kopcem
+ * @param[in] state : nieużywany
+ */
+static void kronecker_overflow_fallback_test(void **state) {
+    (void) state;
+
+    PolyMulTuning forced = kronecker_tuning(2);
+    Poly p = random_poly(3, 3, INT_MAX / 2, 32);
+    Poly q = random_poly(3, 2, INT_MAX / 2, 32);
+
+    assert_mul_matches_reference(&p, &q, &forced);
+    assert_mul_matches_reference(&q, &q, &forced);
+
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+}
+
+/**
+ * Test podstawienia Kroneckera dla iloczynu liścia i wielomianu wielu
+ * zmiennych
+ * @param[in] state : nieużywany
+ */
+static void kronecker_leaf_complex_test(void **state) {
+    (void) state;
+
+    PolyMulTuning sparse = kronecker_tuning(SIZE_MAX);
+    PolyMulTuning dense = kronecker_tuning(2);
+    long coeffs[] = {3, -1, LONG_MAX, 0, 7, LONG_MIN};
+    Poly leaf = create_dense_poly(coeffs, 6, 2);
+    Poly complex = random_poly(3, 3, 4, 64);
+
+    assert_int_equal(leaf.tag, LEAF);
+    assert_mul_matches_reference(&leaf, &complex, &sparse);
+    assert_mul_matches_reference(&complex, &leaf, &dense);
+
+    PolyDestroy(&leaf);
+    PolyDestroy(&complex);
+}
+
+/**
+ * Sprawdza, czy kwadrat przy zadanych progach jest równy iloczynowi
+ * wzorcowemu dwóch osobno zbudowanych, równych wielomianów, zob.
+ * set_reference_tuning. Przywraca poprzednie progi.
+ * @param[in] p : wielomian
+ * @param[in] copy : wielomian równy @p p niewspółdzielący z nim pamięci
+ * @param[in] fast : progi sprawdzanej ścieżki
+ */
+static void assert_sqr_matches_reference(const Poly *p, const Poly *copy,
+                                         const PolyMulTuning *fast)
+{
+    PolyMulTuning saved = PolyMulGetTuning();
+    Poly expected, square;
+
+    set_reference_tuning();
+    expected = PolyMul(p, copy);
+    PolyMulSetTuning(fast);
+    square = PolySqr(p);
+    PolyMulSetTuning(&saved);
+
+    assert_true(PolyIsEq(&expected, &square));
+
+    PolyDestroy(&expected);
+    PolyDestroy(&square);
+}
+
+/**
+ * Zwraca progi wymuszające mnożenie liści metodą Karatsuby
+ * @param[in] cutoff : długość, poniżej której Karatsuba przechodzi na
+ * mnożenie szkolne
+ * @return progi
+ */
+static PolyMulTuning karatsuba_tuning(size_t cutoff)
+{
+    PolyMulTuning tuning;
+
+    memset(&tuning, 0, sizeof(tuning));
+    tuning.karatsuba_cutoff = cutoff;
+    tuning.karatsuba_density = 1024;
+    tuning.ntt_threshold = SIZE_MAX;
+    tuning.kronecker_min_products = SIZE_MAX;
+    return tuning;
+}
+
+/**
+ * Wypełnia tablicę losowymi współczynnikami
+ * @param[out] coeffs : tablica
+ * @param[in] count : długość tablicy
+ * @param[in] bits : rozmiar współczynników, zob. random_coeff
+ */
+static void random_coeffs(long coeffs[], size_t count, unsigned bits)
+{
+    for (size_t i = 0; i < count; i++) {
+        coeffs[i] = random_coeff(bits);
+    }
+}
+
+/**
+ * Test KaratsubaMul i KaratsubaBalanced z małymi progami: czynniki różnej
+ * długości o wykładnikach niezaczynających się od zera
+ * @param[in] state : nieużywany
+ */
+static void karatsuba_mul_test(void **state) {
+    (void) state;
+
+    static const size_t lengths[] = {1, 2, 3, 5, 8, 13, 31, 64, 97};
+    static const poly_exp_t firsts[] = {0, 1, 1000};
+    long a[97], b[97];
+    PolyMulTuning tuning;
+    Poly p, q;
+
+    for (size_t cutoff = 1; cutoff <= 4; cutoff++) {
+        tuning = karatsuba_tuning(cutoff);
+        for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+            for (size_t j = 0; j <= i; j++) {
+                random_coeffs(a, lengths[i], 64);
+                random_coeffs(b, lengths[j], 64);
+                p = create_dense_poly(a, lengths[i], firsts[i % 3]);
+                q = create_dense_poly(b, lengths[j], firsts[(i + j) % 3]);
+                assert_mul_matches_reference(&p, &q, &tuning);
+                assert_mul_matches_reference(&q, &p, &tuning);
+                PolyDestroy(&p);
+                PolyDestroy(&q);
+            }
+        }
+    }
+}
+
+/**
+ * Test KaratsubaSqr z małymi progami, dla wielomianów o wykładnikach
+ * niezaczynających się od zera
+ * @param[in] state : nieużywany
+ */
+static void karatsuba_sqr_test(void **state) {
+    (void) state;
+
+    long a[97];
+    PolyMulTuning tuning;
+    Poly p, copy;
+
+    for (size_t cutoff = 1; cutoff <= 4; cutoff++) {
+        tuning = karatsuba_tuning(cutoff);
+        for (size_t n = 1; n <= 97; n += 6) {
+            random_coeffs(a, n, 64);
+            p = create_dense_poly(a, n, (poly_exp_t) (n % 7));
+            copy = create_dense_poly(a, n, (poly_exp_t) (n % 7));
+            assert_sqr_matches_reference(&p, &copy, &tuning);
+            PolyDestroy(&p);
+            PolyDestroy(&copy);
+        }
+    }
+}
+
+/**
+ * Zwraca progi wymuszające mnożenie liści transformatą teorioliczbową
+ * z dowolną liczbą liczb pierwszych
+ * @return progi
+ */
+static PolyMulTuning ntt_tuning(void)
+{
+    PolyMulTuning tuning = karatsuba_tuning(1);
+
+    tuning.ntt_threshold = 1;
+    tuning.ntt_prime_factor = 1;
+    return tuning;
+}
+
+/**
+ * Sprawdza iloczyn i kwadrat liści liczone transformatą teorioliczbową
+ * z zadaną liczbą liczb pierwszych
+ * @param[in] a : współczynniki pierwszego czynnika
+ * @param[in] n : długość @p a
+ * @param[in] b : współczynniki drugiego czynnika
+ * @param[in] m : długość @p b
+ * @param[in] primes : oczekiwana liczba liczb pierwszych iloczynu
+ */
+static void assert_ntt_matches_reference(const long a[], size_t n,
+                                         const long b[], size_t m,
+                                         unsigned primes)
+{
+    PolyMulTuning tuning = ntt_tuning();
+    Poly p = create_dense_poly(a, n, 3), q = create_dense_poly(b, m, 0);
+    Poly copy = create_dense_poly(a, n, 3);
+
+    assert_int_equal(NttPrimesNeeded((const unsigned long*) a, n,
+                                     (const unsigned long*) b, m), primes);
+    assert_mul_matches_reference(&p, &q, &tuning);
+    assert_sqr_matches_reference(&p, &copy, &tuning);
+
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    PolyDestroy(&copy);
+}
+
+/**
+ * Test NttMul z jedną, dwiema i trzema liczbami pierwszymi
+ * @param[in] state : nieużywany
+ */
+static void ntt_primes_test(void **state) {
+    (void) state;
+
+    static const unsigned bits[] = {20, 45, 64};
+    long a[200], b[150];
+
+    for (unsigned k = 0; k < 3; k++) {
+        random_coeffs(a, 200, bits[k]);
+        random_coeffs(b, 150, bits[k]);
+        assert_ntt_matches_reference(a, 200, b, 150, k + 1);
+        assert_ntt_matches_reference(b, 7, a, 33, k + 1);
+    }
+}
+
+/**
+ * Test NttMul ze współczynnikami LONG_MIN i LONG_MAX, których iloczyny
+ * zawijają się modulo 2^64
+ * @param[in] state : nieużywany
+ */
+static void ntt_wrap_test(void **state) {
+    (void) state;
+
+    long a[64], b[40];
+
+    for (size_t i = 0; i < 64; i++) {
+        a[i] = i % 3 == 0 ? LONG_MIN : i % 3 == 1 ? LONG_MAX : -1;
+    }
+    for (size_t i = 0; i < 40; i++) {
+        b[i] = i % 2 == 0 ? LONG_MAX : LONG_MIN;
+    }
+    assert_ntt_matches_reference(a, 64, b, 40, NTT_PRIMES);
+    assert_ntt_matches_reference(b, 40, b, 40, NTT_PRIMES);
+    assert_ntt_matches_reference(a, 1, a, 1, NTT_PRIMES);
+}
+
+/**
+ * Sprawdza, czy PolySqr przy zadanych progach daje to samo co PolyMul
+ * przy tych samych progach. Przywraca poprzednie progi.
+ * @param[in] p : wielomian
+ * @param[in] tuning : progi
+ */
+static void assert_sqr_matches_mul(const Poly *p, const PolyMulTuning *tuning)
+{
+    PolyMulTuning saved = PolyMulGetTuning();
+    Poly product, square;
+
+    PolyMulSetTuning(tuning);
+    product = PolyMul(p, p);
+    square = PolySqr(p);
+    PolyMulSetTuning(&saved);
+
+    assert_true(PolyIsEq(&product, &square));
+
+    PolyDestroy(&product);
+    PolyDestroy(&square);
+}
+
+/**
+ * Test PolySqr na wszystkich ścieżkach mnożenia: listy jednomianów,
+ * liście, podstawienie Kroneckera i Karatsuba
+ * @param[in] state : nieużywany
+ */
+static void sqr_paths_test(void **state) {
+    (void) state;
+
+    PolyMulTuning list, defaults, kronecker = kronecker_tuning(2);
+    PolyMulTuning karatsuba = karatsuba_tuning(2);
+    long coeffs[80];
+    Poly p;
+
+    memset(&list, 0, sizeof(list));
+    list.kronecker_min_products = SIZE_MAX;
+    memset(&defaults, 0, sizeof(defaults));
+
+    for (unsigned vars = 1; vars <= 3; vars++) {
+        p = random_poly(vars, 4, 9, 64);
+        assert_sqr_matches_mul(&p, &list);
+        assert_sqr_matches_mul(&p, &defaults);
+        assert_sqr_matches_mul(&p, &kronecker);
+        PolyDestroy(&p);
+    }
+
+    random_coeffs(coeffs, 80, 64);
+    coeffs[0] = LONG_MIN;
+    coeffs[79] = LONG_MAX;
+    p = create_dense_poly(coeffs, 80, 5);
+    assert_sqr_matches_mul(&p, &defaults);
+    assert_sqr_matches_mul(&p, &karatsuba);
+    PolyDestroy(&p);
+}
+
+/**
+ * Test PolyCompose z dużym wykładnikiem, liczonym przez podnoszenie do
+ * kwadratu: porównanie z kolejnymi mnożeniami i z potęgowaniem modulo 2^64
+ * @param[in] state : nieużywany
+ */
+static void sqr_compose_power_test(void **state) {
+    (void) state;
+
+    long linear[] = {1, 1};
+    Poly p = create_p_poly(1, 300), x = create_dense_poly(linear, 2, 0);
+    Poly composed, expected = PolyFromCoeff(1), tmp;
+    unsigned long power = 1, base = 3;
+
+    composed = PolyCompose(&p, 1, &x); /* (x + 1)^300 */
+    for (int i = 0; i < 300; i++) {
+        tmp = PolyMul(&expected, &x);
+        PolyDestroy(&expected);
+        expected = tmp;
+    }
+    assert_true(PolyIsEq(&composed, &expected));
+    PolyDestroy(&composed);
+    PolyDestroy(&expected);
+    PolyDestroy(&p);
+    PolyDestroy(&x);
+
+    p = create_p_poly(1, INT_MAX);
+    x = PolyFromCoeff(3);
+    composed = PolyCompose(&p, 1, &x); /* 3^INT_MAX */
+    for (unsigned long e = INT_MAX; e > 0; e /= 2) {
+        if (e % 2 == 1) {
+            power *= base;
+        }
+        base *= base;
+    }
+    assert_true(PolyIsCoeff(&composed));
+    assert_int_equal(composed.type.c, (long) power);
+    PolyDestroy(&composed);
+    PolyDestroy(&p);
+}
+
+/** Plik progów zapisywany i wczytywany przez tuning_file_test */
+#define TUNING_TEST_FILE "unit_tests_poly_tuning.cfg"
+
+/**
+ * Test PolyMulSaveTuning i PolyMulLoadTuning: zapisane progi wczytują się
+ * bez zmian, a nieznane nazwy, błędne wiersze oraz brakujące i zerowe pola
+ * dają wartości domyślne
+ * @param[in] state : nieużywany
+ */
+static void tuning_file_test(void **state) {
+    (void) state;
+
+    PolyMulTuning saved = PolyMulGetTuning(), defaults, custom, expected;
+    PolyMulTuning loaded;
+    FILE *file;
+
+    memset(&defaults, 0, sizeof(defaults));
+    PolyMulSetTuning(&defaults);
+    defaults = PolyMulGetTuning();
+    custom.karatsuba_cutoff = 7;
+    custom.karatsuba_density = 3;
+    custom.ntt_threshold = 4096;
+    custom.ntt_prime_factor = 2;
+    custom.kronecker_min_products = 100;
+    custom.kronecker_max_span = 1u << 16;
+    custom.kronecker_sparsity = 5;
+    custom.multipoint_threshold = 1000;
+    PolyMulSetTuning(&custom);
+    assert_true(PolyMulSaveTuning(TUNING_TEST_FILE));
+    PolyMulSetTuning(&defaults);
+    assert_true(PolyMulLoadTuning(TUNING_TEST_FILE));
+    loaded = PolyMulGetTuning();
+    assert_memory_equal(&loaded, &custom, sizeof(custom));
+
+    file = fopen(TUNING_TEST_FILE, "w");
+    assert_non_null(file);
+    fputs("karatsuba_cutoff 9\n"
+          "unknown_key 5\n"
+          "ntt_threshold\n"
+          "ntt_prime_factor -3\n"
+          "kronecker_sparsity 12abc\n"
+          "kronecker_min_products 0\n"
+          "garbage\n"
+          "multipoint_threshold 77 88\n"
+          "kronecker_max_span 1234\n", file);
+    fclose(file);
+    assert_true(PolyMulLoadTuning(TUNING_TEST_FILE));
+    loaded = PolyMulGetTuning();
+    expected = defaults;
+    expected.karatsuba_cutoff = 9;
+    expected.kronecker_max_span = 1234;
+    assert_memory_equal(&loaded, &expected, sizeof(expected));
+
+    assert_int_equal(remove(TUNING_TEST_FILE), 0);
+    assert_false(PolyMulLoadTuning(TUNING_TEST_FILE));
+    loaded = PolyMulGetTuning();
+    assert_memory_equal(&loaded, &expected, sizeof(expected));
+    PolyMulSetTuning(&saved);
+}
 
 /**
- * Funkcja main testująca funkcję PolyCompose i COMPOSE kalkulatora
+ * Wylicza wartość wielomianu kolejnymi wywołaniami PolyAt, podstawiając
+ * zero pod zmienne o indeksach od @p n
+ * @param[in] p : wielomian
+ * @param[in] vars : liczba zmiennych @p p
+ * @param[in] n : liczba wartości w tablicy @p xs
+ * @param[in] xs : wartości kolejnych zmiennych
+ * @return wartość wielomianu
+ */
+static long eval_by_at(const Poly *p, unsigned vars, unsigned n,
+                       const long xs[])
+{
+    Poly value = PolyClone(p), tmp;
+    long result;
+
+    for (unsigned i = 0; i < vars; i++) {
+        tmp = PolyAt(&value, i < n ? xs[i] : 0);
+        PolyDestroy(&value);
+        value = tmp;
+    }
+    assert_true(PolyIsCoeff(&value));
+    result = value.type.c;
+    PolyDestroy(&value);
+    return result;
+}
+
+/**
+ * Test PolyEval i PolyEvalCompiled: porównanie z kolejnymi wywołaniami
+ * PolyAt dla skrajnych wartości zmiennych i różnej liczby podanych wartości
+ * @param[in] state : nieużywany
+ */
+static void eval_matches_chained_at_test(void **state) {
+    (void) state;
+
+    long xs[5];
+    const long edges[] = {LONG_MIN, LONG_MAX, 0, -1, 1};
+    Poly p;
+    PolyEvalPlan plan;
+
+    for (unsigned vars = 0; vars <= 4; vars++) {
+        for (int round = 0; round < 8; round++) {
+            p = random_poly(vars, 4, 70, 64);
+            plan = PolyCompileEval(&p);
+            for (unsigned i = 0; i < 5; i++) {
+                xs[i] = round < 5 ? edges[(round + i) % 5] : random_coeff(64);
+            }
+            for (unsigned n = 0; n <= 5; n++) {
+                long expected = eval_by_at(&p, vars, n, xs);
+
+                assert_int_equal(PolyEval(&p, n, xs), expected);
+                assert_int_equal(PolyEvalCompiled(&plan, n, xs), expected);
+            }
+            PolyEvalPlanDestroy(&plan);
+            PolyDestroy(&p);
+        }
+    }
+}
+
+/**
+ * Test PolyEval na wielomianach o skrajnych współczynnikach; wartości
+ * przepełniają long i obie ścieżki liczą je modulo 2^64
+ * @param[in] state : nieużywany
+ */
+static void eval_extreme_coeffs_test(void **state) {
+    (void) state;
+
+    const long coeffs[] = {LONG_MIN, LONG_MAX, LONG_MIN, -1, LONG_MAX};
+    const long xs[] = {LONG_MIN, LONG_MAX, -1, 2, 3};
+    Poly inner = create_dense_poly(coeffs, 5, 0), outer, p;
+    Mono monos[2];
+
+    outer = PolyClone(&inner);
+    monos[0] = MonoFromPoly(&inner, 0);
+    monos[1] = MonoFromPoly(&outer, 63);
+    p = PolyAddMonos(2, monos);
+    for (unsigned i = 0; i < 5; i++) {
+        for (unsigned j = 0; j < 5; j++) {
+            long point[] = {xs[i], xs[j]};
+
+            assert_int_equal(PolyEval(&p, 2, point),
+                             eval_by_at(&p, 2, 2, point));
+        }
+    }
+    PolyDestroy(&p);
+}
+
+/** Liczba punktów testów wariantów instrukcji, z niepełnymi blokami */
+#define BATCH_TEST_POINTS 75
+
+/**
+ * Losuje punkty, wśród których są wartości skrajne
+ * @param[out] xs : punkty
+ * @param[in] k : liczba punktów
+ */
+static void random_points(long xs[], size_t k)
+{
+    const long edges[] = {LONG_MIN, LONG_MAX, 0, -1, 1};
+
+    for (size_t j = 0; j < k; j++) {
+        xs[j] = j < 5 ? edges[j] : random_coeff(64);
+    }
+}
+
+/**
+ * Test wariantów instrukcji BatchHorner: każdy obsługiwany wariant daje
+ * te same wartości co zwykły kod dla każdej liczby punktów, także gdy nie
+ * jest ona wielokrotnością szerokości rejestru
+ * @param[in] state : nieużywany
+ */
+static void batch_variants_agree_test(void **state) {
+    (void) state;
+
+    const enum BatchVariant variants[] = {BATCH_AVX2, BATCH_AVX512};
+    unsigned long coeffs[40], xs[BATCH_TEST_POINTS];
+    unsigned long expected[BATCH_TEST_POINTS], out[BATCH_TEST_POINTS];
+    int exps[40];
+
+    random_coeffs((long*) coeffs, 40, 64);
+    random_points((long*) xs, BATCH_TEST_POINTS);
+    for (int i = 0; i < 40; i++) {
+        exps[i] = 3 * i + i % 2;
+    }
+    for (size_t k = 1; k <= BATCH_TEST_POINTS; k++) {
+        assert_true(BatchSetVariant(BATCH_GENERIC));
+        assert_int_equal(BatchGetVariant(), BATCH_GENERIC);
+        BatchHorner(coeffs, exps, 40, k, xs, expected);
+        for (size_t v = 0; v < sizeof(variants) / sizeof(variants[0]); v++) {
+            if (!BatchSetVariant(variants[v])) {
+                continue;
+            }
+            assert_int_equal(BatchGetVariant(), variants[v]);
+            memset(out, 0, sizeof(out));
+            BatchHorner(coeffs, exps, 40, k, xs, out);
+            assert_memory_equal(out, expected, sizeof(unsigned long) * k);
+        }
+    }
+    assert_true(BatchSetVariant(BATCH_AUTO));
+}
+
+/**
+ * Test PolyAtMany i PolyEvalMany w każdym wariancie instrukcji: porównanie
+ * z PolyAt w pojedynczych punktach, dla liczby punktów niebędącej
+ * wielokrotnością szerokości rejestru
+ * @param[in] state : nieużywany
+ */
+static void batch_variants_match_at_test(void **state) {
+    (void) state;
+
+    const enum BatchVariant variants[] = {BATCH_GENERIC, BATCH_AVX2,
+                                          BATCH_AVX512};
+    const size_t counts[] = {1, 3, 7, 8, 9, 15, 17, 33, BATCH_TEST_POINTS};
+    PolyMulTuning saved = PolyMulGetTuning(), tuning = saved;
+    long coeffs[50], xs[2 * BATCH_TEST_POINTS], out[BATCH_TEST_POINTS];
+    long point[2];
+    Poly dense, nested, value;
+
+    tuning.multipoint_threshold = SIZE_MAX;
+    PolyMulSetTuning(&tuning);
+    random_coeffs(coeffs, 50, 64);
+    coeffs[0] = LONG_MIN;
+    coeffs[49] = LONG_MAX;
+    dense = create_dense_poly(coeffs, 50, 2);
+    assert_int_equal(dense.tag, LEAF);
+    nested = random_poly(2, 6, 40, 64);
+    random_points(xs, 2 * BATCH_TEST_POINTS);
+    for (size_t v = 0; v < sizeof(variants) / sizeof(variants[0]); v++) {
+        if (!BatchSetVariant(variants[v])) {
+            continue;
+        }
+        for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+            size_t k = counts[c];
+
+            assert_true(PolyAtMany(&dense, k, xs, out));
+            for (size_t j = 0; j < k; j++) {
+                value = PolyAt(&dense, xs[j]);
+                assert_true(PolyIsCoeff(&value));
+                assert_int_equal(out[j], value.type.c);
+            }
+            PolyEvalMany(&nested, 2, k, xs, out);
+            for (size_t j = 0; j < k; j++) {
+                point[0] = xs[j];
+                point[1] = xs[k + j];
+                assert_int_equal(out[j], eval_by_at(&nested, 2, 2, point));
+            }
+        }
+    }
+    assert_true(BatchSetVariant(BATCH_AUTO));
+    PolyMulSetTuning(&saved);
+    PolyDestroy(&dense);
+    PolyDestroy(&nested);
+}
+
+/**
+ * Sprawdza, czy PolyAtManyTree daje te same wartości co PolyAt i PolyEval
+ * w pojedynczych punktach; wszystkie trzy liczą modulo 2^64
+ * @param[in] p : wielomian o stałych współczynnikach
+ * @param[in] k : liczba punktów
+ * @param[in] xs : punkty
+ */
+static void assert_tree_matches_at(const Poly *p, size_t k, const long xs[])
+{
+    long *out = (long*) malloc(sizeof(long) * k);
+    Poly value;
+
+    assert_non_null(out);
+    assert_true(PolyAtManyTree(p, k, xs, out));
+    for (size_t j = 0; j < k; j++) {
+        value = PolyAt(p, xs[j]);
+        assert_true(PolyIsCoeff(&value));
+        assert_int_equal(out[j], value.type.c);
+        assert_int_equal(out[j], PolyEval(p, 1, xs + j));
+    }
+    free(out);
+}
+
+/**
+ * Test PolyAtManyTree: porównanie z PolyAt dla skrajnych współczynników
+ * i punktów, także gdy punktów jest więcej niż współczynników
+ * @param[in] state : nieużywany
+ */
+static void tree_matches_at_test(void **state) {
+    (void) state;
+
+    const size_t counts[] = {1, 2, 63, 64, 65, 200, 700};
+    long coeffs[300], xs[700];
+    Poly p;
+
+    random_points(xs, 700);
+    for (int i = 0; i < 300; i++) {
+        coeffs[i] = i % 3 == 0 ? LONG_MIN : i % 3 == 1 ? LONG_MAX : 0;
+    }
+    p = create_dense_poly(coeffs, 300, 0);
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        assert_tree_matches_at(&p, counts[c], xs);
+    }
+    PolyDestroy(&p);
+
+    random_coeffs(coeffs, 300, 64);
+    coeffs[0] = LONG_MIN;
+    coeffs[299] = LONG_MAX;
+    p = create_dense_poly(coeffs, 300, 5);
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        assert_tree_matches_at(&p, counts[c], xs);
+    }
+    PolyDestroy(&p);
+}
+
+/**
+ * Test progu multipoint_threshold: PolyAtMany wartościuje drzewem
+ * podiloczynów dokładnie wtedy, gdy liczba punktów i długość liścia
+ * osiągają próg, a wyniki obu metod są równe
+ * @param[in] state : nieużywany
+ */
+static void multipoint_dispatch_test(void **state) {
+    (void) state;
+
+    PolyMulTuning saved = PolyMulGetTuning(), tuning = saved;
+    long coeffs[100], xs[200], tree[200], batch[200];
+    PolyEvalStats before, after;
+    Poly p;
+
+    random_coeffs(coeffs, 100, 64);
+    random_points(xs, 200);
+    p = create_dense_poly(coeffs, 100, 0);
+    assert_int_equal(p.tag, LEAF);
+
+    tuning.multipoint_threshold = 100;
+    PolyMulSetTuning(&tuning);
+    before = PolyEvalGetStats();
+    assert_true(PolyAtMany(&p, 200, xs, tree));
+    after = PolyEvalGetStats();
+    assert_int_equal(after.tree_calls, before.tree_calls + 1);
+    assert_int_equal(after.batch_calls, before.batch_calls);
+
+    before = after;
+    assert_true(PolyAtMany(&p, 99, xs, batch));
+    after = PolyEvalGetStats();
+    assert_int_equal(after.tree_calls, before.tree_calls);
+    assert_int_equal(after.batch_calls, before.batch_calls + 1);
+    assert_memory_equal(tree, batch, sizeof(long) * 99);
+
+    tuning.multipoint_threshold = 101;
+    PolyMulSetTuning(&tuning);
+    before = after;
+    assert_true(PolyAtMany(&p, 200, xs, batch));
+    after = PolyEvalGetStats();
+    assert_int_equal(after.tree_calls, before.tree_calls);
+    assert_int_equal(after.batch_calls, before.batch_calls + 1);
+    assert_memory_equal(tree, batch, sizeof(tree));
+
+    PolyMulSetTuning(&saved);
+    PolyDestroy(&p);
+}
+
+/**
+ * Kopiuje wielomian tak, żeby jego najwyższy poziom nie był współdzielony
+ * @param[in] p : wielomian
+ * @return kopia
+ */
+static Poly copy_poly(const Poly *p)
+{
+    Poly neg = PolyNeg(p), copy = PolyNeg(&neg);
+
+    PolyDestroy(&neg);
+    return copy;
+}
+
+/**
+ * Sprawdza, czy PolySubInPlace i PolySubOwned dają ten sam wynik co
+ * PolySub, gdy odjemna jest współdzielona i gdy nie jest, i czy nie
+ * zmieniają wielomianów współdzielących z nimi poziomy
+ * @param[in] p : odjemna
+ * @param[in] q : odjemnik
+ */
+static void assert_sub_matches(const Poly *p, const Poly *q)
+{
+    Poly expected = PolySub(p, q), p_before = copy_poly(p);
+    Poly q_before = copy_poly(q), diff, owned_p, owned_q;
+
+    for (int shared = 0; shared <= 1; shared++) {
+        diff = shared ? PolyClone(p) : copy_poly(p);
+        PolySubInPlace(&diff, q);
+        assert_true(PolyIsEq(&diff, &expected));
+        PolyDestroy(&diff);
+
+        owned_p = shared ? PolyClone(p) : copy_poly(p);
+        owned_q = shared ? PolyClone(q) : copy_poly(q);
+        diff = PolySubOwned(&owned_p, &owned_q);
+        assert_true(PolyIsEq(&diff, &expected));
+        assert_true(PolyIsZero(&owned_p));
+        assert_true(PolyIsZero(&owned_q));
+        PolyDestroy(&diff);
+
+        assert_true(PolyIsEq(p, &p_before));
+        assert_true(PolyIsEq(q, &q_before));
+    }
+    PolyDestroy(&expected);
+    PolyDestroy(&p_before);
+    PolyDestroy(&q_before);
+}
+
+/**
+ * Test PolySubInPlace i PolySubOwned: porównanie z PolySub dla list,
+ * liści i tablic, odejmowania wielomianu od samego siebie i jednomianów,
+ * które się znoszą
+ * @param[in] state : nieużywany
+ */
+static void sub_in_place_test(void **state) {
+    (void) state;
+
+    Poly p, q, leaf, array, diff, same, extra, expected;
+
+    for (int round = 0; round < 8; round++) {
+        p = random_poly(2 + round % 2, 6, 10, 8);
+        q = random_poly(2 + round % 2, 6, 10, 8);
+        leaf = random_poly(1, 5, 10, 8);
+        assert_int_equal(leaf.tag, LEAF);
+        array = copy_poly(&p);
+        PolyPack(&array);
+        assert_int_equal(array.tag, ARRAY);
+
+        assert_sub_matches(&p, &q);
+        assert_sub_matches(&leaf, &p);
+        assert_sub_matches(&p, &leaf);
+        assert_sub_matches(&array, &leaf);
+        assert_sub_matches(&array, &q);
+
+        diff = copy_poly(&p);
+        PolySubInPlace(&diff, &diff);
+        assert_true(PolyIsZero(&diff));
+        diff = PolyClone(&p);
+        same = PolyClone(&p);
+        PolySubInPlace(&diff, &same);
+        assert_true(PolyIsZero(&diff));
+        diff = PolySubOwned(&same, &same);
+        assert_true(PolyIsZero(&diff));
+        same = PolyClone(&array);
+        diff = PolyClone(&array);
+        diff = PolySubOwned(&diff, &same);
+        assert_true(PolyIsZero(&diff));
+
+        extra = create_nested_poly(PolyClone(&leaf), 3);
+        same = PolyAdd(&p, &extra);
+        expected = PolyNeg(&extra);
+        assert_sub_matches(&p, &same);
+        diff = PolyClone(&p);
+        diff = PolySubOwned(&diff, &same);
+        assert_true(PolyIsEq(&diff, &expected));
+
+        PolyDestroy(&diff);
+        PolyDestroy(&expected);
+        PolyDestroy(&extra);
+        PolyDestroy(&array);
+        PolyDestroy(&leaf);
+        PolyDestroy(&q);
+        PolyDestroy(&p);
+    }
+}
+
+
+/**
+ * Sprawdza, czy PolyMulScalar, PolyAddScalar i ich wersje działające
+ * w miejscu dają ten sam wynik co PolyMul i PolyAdd ze stałą, gdy
+ * argument jest współdzielony i gdy nie jest
+ * @param[in] p : wielomian
+ * @param[in] c : skalar
+ */
+static void assert_scalar_matches(const Poly *p, long c)
+{
+    Poly scalar = PolyFromCoeff(c), before = copy_poly(p), result;
+    Poly expected_mul = PolyMul(p, &scalar);
+    Poly expected_add = PolyAdd(p, &scalar);
+
+    result = PolyMulScalar(p, c);
+    assert_true(PolyIsEq(&result, &expected_mul));
+    PolyDestroy(&result);
+    result = PolyAddScalar(p, c);
+    assert_true(PolyIsEq(&result, &expected_add));
+    PolyDestroy(&result);
+    for (int shared = 0; shared <= 1; shared++) {
+        result = shared ? PolyClone(p) : copy_poly(p);
+        PolyMulScalarInPlace(&result, c);
+        assert_true(PolyIsEq(&result, &expected_mul));
+        PolyDestroy(&result);
+        result = shared ? PolyClone(p) : copy_poly(p);
+        PolyAddScalarInPlace(&result, c);
+        assert_true(PolyIsEq(&result, &expected_add));
+        PolyDestroy(&result);
+        assert_true(PolyIsEq(p, &before));
+    }
+    PolyDestroy(&expected_add);
+    PolyDestroy(&expected_mul);
+    PolyDestroy(&before);
+}
+
+/**
+ * Test PolyMulScalar, PolyAddScalar, PolyMulScalarInPlace
+ * i PolyAddScalarInPlace: porównanie z PolyMul i PolyAdd dla stałych,
+ * liści, list i tablic, skalarów 0, 1 i -1, skalara znoszącego jednomian
+ * stopnia zero i wyników, które stają się stałą
+ * @param[in] state : nieużywany
+ */
+static void scalar_ops_test(void **state) {
+    (void) state;
+
+    const long scalars[] = {0, 1, -1, 3, LONG_MIN, LONG_MAX};
+    const long leaf_coeffs[] = {5, 0, 2};
+    const long min_coeffs[] = {0, LONG_MIN, LONG_MIN};
+    Poly polys[6], leaf, nested, tmp, result;
+
+    polys[0] = PolyFromCoeff(7);
+    polys[1] = create_dense_poly(leaf_coeffs, 3, 0); /* 5 + 2x^2 */
+    polys[2] = random_poly(2, 6, 10, 8);
+    polys[3] = copy_poly(&polys[2]);
+    PolyPack(&polys[3]);
+    leaf = PolyClone(&polys[1]);
+    tmp = create_nested_poly(random_poly(1, 4, 6, 8), 2);
+    polys[4] = create_nested_poly(leaf, 0);
+    polys[4] = PolyAddOwned(&polys[4], &tmp); /* (5 + 2x_1^2) + q x_0^2 */
+    tmp = PolyFromCoeff(5);
+    nested = create_nested_poly(random_poly(1, 4, 6, 8), 3);
+    polys[5] = PolyAdd(&tmp, &nested); /* 5 + q x_0^3 */
+    PolyDestroy(&nested);
+    for (int i = 0; i < 6; i++) {
+        for (size_t j = 0; j < sizeof(scalars) / sizeof(scalars[0]); j++) {
+            assert_scalar_matches(&polys[i], scalars[j]);
+        }
+        assert_scalar_matches(&polys[i], -5);
+    }
+
+    /* -5 znosi jednomian stopnia zero */
+    result = PolyClone(&polys[1]);
+    PolyAddScalarInPlace(&result, -5);
+    tmp = create_dense_poly(leaf_coeffs + 2, 1, 2);
+    assert_int_equal(result.tag, LEAF);
+    assert_true(PolyIsEq(&result, &tmp));
+    PolyDestroy(&tmp);
+    PolyDestroy(&result);
+
+    /* liść i lista, które po pomnożeniu przez 2 stają się stałą */
+    leaf = create_dense_poly(min_coeffs, 3, 0);
+    result = PolyClone(&leaf);
+    PolyMulScalarInPlace(&result, 2);
+    assert_true(PolyIsZero(&result));
+    assert_scalar_matches(&leaf, 2);
+    tmp = PolyFromCoeff(3);
+    nested = create_nested_poly(leaf, 1);
+    nested = PolyAddOwned(&nested, &tmp); /* 3 + LONG_MIN (x_1 + x_1^2) x_0 */
+    assert_scalar_matches(&nested, 2);
+    result = PolyMulScalar(&nested, 2);
+    assert_true(PolyIsCoeff(&result));
+    assert_int_equal(result.type.c, 6);
+    PolyMulScalarInPlace(&nested, 2);
+    assert_true(PolyIsCoeff(&nested));
+    assert_int_equal(nested.type.c, 6);
+
+    for (int i = 0; i < 6; i++) {
+        PolyDestroy(&polys[i]);
+    }
+}
+
+/**
+ * Test PolyBucket: suma wielu wielomianów różnych rodzajów (stałych,
+ * liści, list, tablic i wielomianów znoszących poprzednie) w akumulatorze
+ * jest równa sumie liczonej kolejnymi wywołaniami PolyAdd
+ * @param[in] state : nieużywany
+ */
+static void bucket_matches_add_test(void **state) {
+    (void) state;
+
+    PolyBucket bucket;
+    Poly expected = PolyZero(), operand, previous = PolyZero(), sum, tmp;
+
+    PolyBucketInit(&bucket);
+    sum = PolyBucketSum(&bucket);
+    assert_true(PolyIsZero(&sum));
+    for (int i = 0; i < 300; i++) {
+        switch (i % 6) {
+            case 0:
+                operand = PolyFromCoeff(i % 12 == 0 ? LONG_MIN
+                                                    : random_coeff(8));
+                break;
+            case 1:
+                operand = random_poly(1, 8, 300, 8);
+                break;
+            case 2:
+                operand = random_poly(2, 10, 300, 8);
+                break;
+            case 3:
+                operand = copy_poly(&previous);
+                PolyPack(&operand);
+                break;
+            case 4:
+                operand = PolyNeg(&previous);
+                break;
+            default:
+                operand = random_poly(3, 4, 300, 64);
+                break;
+        }
+        tmp = PolyAdd(&expected, &operand);
+        PolyDestroy(&expected);
+        expected = tmp;
+        PolyDestroy(&previous);
+        previous = PolyClone(&operand);
+        PolyBucketAdd(&bucket, &operand);
+        assert_true(PolyIsZero(&operand));
+    }
+    sum = PolyBucketSum(&bucket);
+    assert_true(PolyIsEq(&sum, &expected));
+    PolyDestroy(&sum);
+    PolyDestroy(&previous);
+
+    /* suma, w której wszystko się znosi, i suma samych stałych */
+    PolyBucketInit(&bucket);
+    operand = PolyNeg(&expected);
+    PolyBucketAdd(&bucket, &operand);
+    operand = PolyClone(&expected);
+    PolyBucketAdd(&bucket, &operand);
+    sum = PolyBucketSum(&bucket);
+    assert_true(PolyIsZero(&sum));
+    operand = PolyFromCoeff(LONG_MAX);
+    PolyBucketAdd(&bucket, &operand);
+    operand = PolyFromCoeff(2);
+    PolyBucketAdd(&bucket, &operand);
+    sum = PolyBucketSum(&bucket);
+    assert_true(PolyIsCoeff(&sum));
+    assert_int_equal(sum.type.c, LONG_MIN + 1);
+    PolyDestroy(&expected);
+}
+
+/**
+ * Sprawdza, czy wszystkie poziomy wielomianu niebędące stałymi ani
+ * liśćmi są w reprezentacji tablicowej
+ * @param[in] p : wielomian
+ */
+static void assert_packed(const Poly *p)
+{
+    Poly coeff;
+
+    if (PolyIsZero(p) || PolyIsCoeff(p) || p->tag == LEAF) {
+        return;
+    }
+    assert_int_equal(p->tag, ARRAY);
+    for (const Mono *m = p->type.m; m != NULL; m = MonoNext(m)) {
+        coeff = MonoGetPoly(m);
+        assert_packed(&coeff);
+    }
+}
+
+/**
+ * Sprawdza, czy działanie na wielomianach spakowanych daje ten sam wynik
+ * co na listach
+ * @param[in] op : działanie
+ * @param[in] p : wielomian w reprezentacji listowej
+ * @param[in] q : wielomian w reprezentacji listowej
+ * @param[in] packed_p : @p p po PolyPack
+ * @param[in] packed_q : @p q po PolyPack
+ */
+static void assert_packed_op_matches(Poly (*op)(const Poly *, const Poly *),
+                                     const Poly *p, const Poly *q,
+                                     const Poly *packed_p,
+                                     const Poly *packed_q)
+{
+    Poly expected = op(p, q), result;
+
+    result = op(packed_p, packed_q);
+    assert_true(PolyIsEq(&result, &expected));
+    PolyDestroy(&result);
+    result = op(packed_p, q);
+    assert_true(PolyIsEq(&result, &expected));
+    PolyDestroy(&result);
+    result = op(p, packed_q);
+    assert_true(PolyIsEq(&result, &expected));
+    PolyDestroy(&result);
+    PolyDestroy(&expected);
+}
+
+/**
+ * Test reprezentacji tablicowej: PolyPack zamienia na tablice wszystkie
+ * poziomy zagnieżdżonego wielomianu, nie zmieniając wielomianów
+ * współdzielących z nim poziomy, a PolyAdd, PolySub, PolyMul, PolyIsEq
+ * i PolyDestroy dają na nim te same wyniki co na listach
+ * @param[in] state : nieużywany
+ */
+static void pack_matches_list_test(void **state) {
+    (void) state;
+
+    Poly p, q, packed_p, packed_q, shared, coeff;
+
+    for (int round = 0; round < 8; round++) {
+        p = random_poly(2 + round % 3, 5, 20, 16);
+        q = random_poly(2 + round % 3, 5, 20, 16);
+        packed_p = copy_poly(&p);
+        PolyPack(&packed_p);
+        shared = PolyClone(&q);
+        packed_q = PolyClone(&q);
+        PolyPack(&packed_q);
+        assert_packed(&packed_p);
+        assert_packed(&packed_q);
+
+        assert_true(PolyIsEq(&packed_p, &p));
+        assert_true(PolyIsEq(&p, &packed_p));
+        assert_true(PolyIsEq(&packed_q, &shared));
+        assert_false(PolyIsEq(&packed_p, &packed_q));
+        assert_int_equal(PolyDeg(&packed_p), PolyDeg(&p));
+        assert_packed_op_matches(PolyAdd, &p, &q, &packed_p, &packed_q);
+        assert_packed_op_matches(PolySub, &p, &q, &packed_p, &packed_q);
+        assert_packed_op_matches(PolyMul, &p, &q, &packed_p, &packed_q);
+        assert_packed_op_matches(PolySub, &p, &p, &packed_p, &packed_p);
+
+        PolyPack(&packed_p);
+        assert_packed(&packed_p);
+        assert_true(PolyIsEq(&packed_p, &p));
+        coeff = PolyFromCoeff(round);
+        PolyPack(&coeff);
+        assert_true(PolyIsCoeff(&coeff));
+        assert_int_equal(coeff.type.c, round);
+
+        PolyDestroy(&packed_q);
+        assert_true(PolyIsEq(&shared, &q));
+        PolyDestroy(&shared);
+        PolyDestroy(&packed_p);
+        PolyDestroy(&q);
+        PolyDestroy(&p);
+    }
+}
+
+
+/**
+ * Funkcja main uruchamiająca testy funkcji biblioteki i poleceń kalkulatora
  */
 int main(void) {
     const struct CMUnitTest tests1[] = {
@@ -487,6 +2048,75 @@ int main(void) {
             cmocka_unit_test_setup(compose_digits_and_letters_test, test_setup)
     };
 
+    const struct CMUnitTest tests3[] = {
+            /* PolyMemStats and MEM tests */
+            cmocka_unit_test(mem_stats_shared_test),
+            cmocka_unit_test(mem_stats_shared_coeff_test),
+            cmocka_unit_test_setup(mem_empty_stack_test, test_setup)
+    };
+
+    const struct CMUnitTest tests4[] = {
+            /* PolyIntern tests */
+            cmocka_unit_test_setup(intern_keeps_results_test, test_setup),
+            cmocka_unit_test(intern_grow_releases_chain_test)
+    };
+
+    const struct CMUnitTest tests5[] = {
+            /* PolyReclaim tests */
+            cmocka_unit_test(reclaim_drain_test),
+            cmocka_unit_test(reclaim_stop_then_destroy_test)
+    };
+
+    const struct CMUnitTest tests6[] = {
+            /* Region tests */
+            cmocka_unit_test(region_nested_save_restore_test),
+            cmocka_unit_test(region_spill_test)
+    };
+
+    const struct CMUnitTest tests7[] = {
+            /* PolyMul tests */
+            cmocka_unit_test(kronecker_forced_test),
+            cmocka_unit_test(kronecker_overflow_fallback_test),
+            cmocka_unit_test(kronecker_leaf_complex_test),
+            cmocka_unit_test(karatsuba_mul_test),
+            cmocka_unit_test(karatsuba_sqr_test),
+            cmocka_unit_test(ntt_primes_test),
+            cmocka_unit_test(ntt_wrap_test),
+            cmocka_unit_test(sqr_paths_test),
+            cmocka_unit_test(sqr_compose_power_test),
+            cmocka_unit_test(tuning_file_test)
+    };
+
+    const struct CMUnitTest tests8[] = {
+            /* PolyEval and PolyAtMany tests */
+            cmocka_unit_test(eval_matches_chained_at_test),
+            cmocka_unit_test(eval_extreme_coeffs_test),
+            cmocka_unit_test(batch_variants_agree_test),
+            cmocka_unit_test(batch_variants_match_at_test),
+            cmocka_unit_test(tree_matches_at_test),
+            cmocka_unit_test(multipoint_dispatch_test)
+    };
+
+    const struct CMUnitTest tests9[] = {
+            /* In-place and owned arithmetic tests */
+            cmocka_unit_test(sub_in_place_test),
+            cmocka_unit_test(scalar_ops_test),
+            cmocka_unit_test(bucket_matches_add_test)
+    };
+
+    const struct CMUnitTest tests10[] = {
+            /* PolyPack and ARRAY layout tests */
+            cmocka_unit_test(pack_matches_list_test)
+    };
+
     return cmocka_run_group_tests(tests1, NULL, NULL) ||
-            cmocka_run_group_tests(tests2, NULL, NULL);
+            cmocka_run_group_tests(tests2, NULL, NULL) ||
+            cmocka_run_group_tests(tests3, NULL, NULL) ||
+            cmocka_run_group_tests(tests4, NULL, NULL) ||
+            cmocka_run_group_tests(tests5, NULL, NULL) ||
+            cmocka_run_group_tests(tests6, NULL, NULL) ||
+            cmocka_run_group_tests(tests7, NULL, NULL) ||
+            cmocka_run_group_tests(tests8, NULL, NULL) ||
+            cmocka_run_group_tests(tests9, NULL, NULL) ||
+            cmocka_run_group_tests(tests10, NULL, NULL);
 }
\ No newline at end of file